@@ -0,0 +1,80 @@
+#!/usr/bin/python3
+
+# Pretty-print the DDR training telemetry record returned by the
+# MBOX_CMD_DDR_TELEMETRY mailbox command (struct ddr_telemetry in
+# wtmi/ddr/ddrcore.h).
+#
+# Input is either the 64 byte record in binary, or the 16 output argument words
+# in hexadecimal, separated by whitespace.
+
+from struct import unpack
+from sys import argv, stderr, stdin
+
+VERSION = 1
+SIZE = 64
+VREF_STEP = 4
+
+flag_names = ['warm-boot', 'cached', 'failed', 'qs-gating', 'vref-training', 'dll-tuning']
+dll_names = ['byte 0 master', 'byte 0 neg', 'byte 1 master', 'byte 1 neg']
+
+def parse(data):
+	try:
+		words = [int(w, 16) for w in data.decode('ascii').split()]
+		if len(words) * 4 >= SIZE:
+			return b''.join(w.to_bytes(4, 'little') for w in words)
+	except (UnicodeDecodeError, ValueError):
+		pass
+
+	return data
+
+def sweep(name, values):
+	print('%s sweep (smallest dll window):' % name)
+	for i, v in enumerate(values):
+		vref = i * VREF_STEP + VREF_STEP - 1
+		print('  0x%02x %3u %s' % (vref, v, '#' * v))
+
+def decode(rec):
+	version, size, ddr_type, cs_num, flags = unpack('<5B', rec[0:5])
+
+	if version != VERSION or size != SIZE or len(rec) < SIZE:
+		print('unsupported record: version %u, size %u' % (version, size), file=stderr)
+		exit(1)
+
+	qs_cycle = rec[5:7]
+	qs_tap = rec[7:9]
+	dll = [unpack('<3B', rec[9 + 3 * i:12 + 3 * i]) for i in range(4)]
+	vref_read, vref_read_range, vref_write, vref_write_min, vref_write_max = unpack('<5B', rec[21:26])
+	vref_read_sweep = rec[26:42]
+	vref_write_sweep = rec[42:58]
+
+	print('DDR%u, %u CS' % (4 if ddr_type == 1 else 3, cs_num))
+	print('flags: %s' % (' '.join(n for i, n in enumerate(flag_names) if flags & (1 << i)) or 'none'))
+
+	if flags & 0x08:
+		for cs in range(cs_num):
+			if qs_cycle[cs] == 0xff:
+				print('qs gating CS%u: failed' % cs)
+			else:
+				print('qs gating CS%u: cycle 0x%02x tap 0x%02x' % (cs, qs_cycle[cs], qs_tap[cs]))
+
+	if flags & 0x20:
+		for name, (left, right, medium) in zip(dll_names, dll):
+			print('dll %-14s window 0x%02x-0x%02x (%2u) medium 0x%02x, margin -%u/+%u' %
+			      (name, left, right, right - left, medium, medium - left, right - medium))
+
+	if flags & 0x10:
+		print('vref read: 0x%02x, dll window %u' % (vref_read, vref_read_range))
+		print('vref write: 0x%02x, passing 0x%02x-0x%02x' % (vref_write, vref_write_min, vref_write_max))
+		sweep('vref read', vref_read_sweep)
+		sweep('vref write', vref_write_sweep)
+
+if len(argv) > 2:
+	print('usage: ddr-telemetry.py [file]', file=stderr)
+	exit(1)
+
+if len(argv) == 2:
+	data = open(argv[1], 'rb').read()
+else:
+	data = stdin.buffer.read()
+
+decode(parse(data))
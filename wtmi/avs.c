@@ -36,6 +36,46 @@
 #include "clock.h"
 #include "avs.h"
 
+/*
+ * The AVS block has no documented indication of the rail having reached the
+ * target voltage, so it is given AVS_SETTLE_US after being enabled. The time is
+ * not spent in a blind delay though: init_avs() returns right away, work which
+ * does not depend on the voltage can be queued by avs_defer(), and
+ * avs_complete() runs it before waiting for the rest of the settle time.
+ */
+#define AVS_SETTLE_US	100000
+#define AVS_DEFER_MAX	4
+
+static void (*avs_deferred[AVS_DEFER_MAX])(void);
+static int avs_deferred_cnt;
+static int avs_settling;
+static u32 avs_enabled_at;
+
+void avs_defer(void (*fn)(void))
+{
+	if (avs_deferred_cnt == AVS_DEFER_MAX)
+		fn();
+	else
+		avs_deferred[avs_deferred_cnt++] = fn;
+}
+
+void avs_complete(void)
+{
+	int i;
+
+	for (i = 0; i < avs_deferred_cnt; ++i)
+		avs_deferred[i]();
+	avs_deferred_cnt = 0;
+
+	if (!avs_settling)
+		return;
+
+	while (get_timer_us() - avs_enabled_at < AVS_SETTLE_US)
+		udelay(10);
+
+	avs_settling = 0;
+}
+
 static int otp_nb_read_parallel(u32 *data)
 {
 	u32 regval;
@@ -165,8 +205,9 @@ int init_avs(u32 speed)
 	regval = readl(MVEBU_AVS_CONTROL0);
 	regval |= (AVS_ENABLE_BIT | SEL_VSENSE0_BIT);
 	writel(regval, MVEBU_AVS_CONTROL0);
-	/* Delay 100ms */
-	udelay(100000);
+	/* settle time is waited for in avs_complete() */
+	avs_enabled_at = get_timer_us();
+	avs_settling = 1;
 
 	return 0;
 }
@@ -102,5 +102,7 @@ enum avs_default_value {
 #define AVS_VDD_MASK		(0x3F)
 
 int init_avs(u32 speed);
+void avs_defer(void (*fn)(void));
+void avs_complete(void);
 
 #endif /* _AVS_H_ */
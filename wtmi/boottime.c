@@ -0,0 +1,78 @@
+#include "types.h"
+#include "io.h"
+#include "clock.h"
+#include "boottime.h"
+#include "debug.h"
+
+static const char * const boottime_names[BOOTTIME_PHASES] = {
+	[BOOTTIME_START]	= "start",
+	[BOOTTIME_UART]		= "uart",
+	[BOOTTIME_AVS]		= "avs",
+	[BOOTTIME_DDR]		= "ddr",
+	[BOOTTIME_EBG]		= "ebg",
+	[BOOTTIME_SOC]		= "soc",
+	[BOOTTIME_MBOX]		= "mbox",
+	[BOOTTIME_AP]		= "ap",
+	[BOOTTIME_LOOP]		= "loop",
+};
+
+static u32 boottime[BOOTTIME_PHASES];
+static u32 boottime_reached;
+
+/*
+ * Record the time at which phase ended. Timestamps are raw readings of
+ * get_timer_us(), so the first one also shows how long it took to get to
+ * secure firmware since the counter started.
+ */
+void boottime_mark(enum boottime_phase phase)
+{
+	boottime[phase] = get_timer_us();
+	boottime_reached |= BIT(phase);
+}
+
+void boottime_flag(enum boottime_flag flag)
+{
+	boottime_reached |= BIT(flag);
+}
+
+/*
+ * out[0] = bitmask of reached phases and boot flags
+ * out[1 + i] = timestamp of phase i
+ *
+ * Returns number of words written.
+ */
+u32 boottime_read(u32 *out)
+{
+	int i;
+
+	out[0] = boottime_reached;
+	for (i = 0; i < BOOTTIME_PHASES; ++i)
+		out[1 + i] = boottime[i];
+
+	return 1 + BOOTTIME_PHASES;
+}
+
+DECL_DEBUG_CMD(cmd_boottime)
+{
+	u32 prev = boottime[BOOTTIME_START];
+	int i;
+
+	printf("%-8s %12s  %12s\n", "phase", "time [us]", "delta [us]");
+	for (i = 0; i < BOOTTIME_PHASES; ++i) {
+		if (!(boottime_reached & BIT(i)))
+			continue;
+
+		printf("%-8s %12u  %12u\n", boottime_names[i], boottime[i],
+		       boottime[i] - prev);
+		prev = boottime[i];
+	}
+
+	printf("%-8s %12s  %12u\n", "total", "", prev - boottime[BOOTTIME_START]);
+
+	if (boottime_reached & BIT(BOOTTIME_FLAG_DDR_CACHED))
+		printf("DDR training restored from cache\n");
+	else if (boottime_reached & BIT(BOOTTIME_FLAG_DDR_STORED))
+		printf("DDR trained, results cached\n");
+}
+
+DEBUG_CMD("boottime", "Show boot timeline", cmd_boottime);
@@ -0,0 +1,35 @@
+#ifndef _BOOTTIME_H_
+#define _BOOTTIME_H_
+
+#include "types.h"
+
+/*
+ * Boot phases, in the order in which they are reached. The values are part of
+ * the MBOX_CMD_BOOTTIME interface, new phases must be added at the end.
+ */
+enum boottime_phase {
+	BOOTTIME_START = 0,
+	BOOTTIME_UART,
+	BOOTTIME_AVS,
+	BOOTTIME_DDR,
+	BOOTTIME_EBG,
+	BOOTTIME_SOC,
+	BOOTTIME_MBOX,
+	BOOTTIME_AP,
+	BOOTTIME_LOOP,
+	BOOTTIME_PHASES,
+};
+
+/*
+ * Boot flags, reported in the upper half of the MBOX_CMD_BOOTTIME phase mask.
+ */
+enum boottime_flag {
+	BOOTTIME_FLAG_DDR_CACHED = 16,	/* DDR training restored from cache */
+	BOOTTIME_FLAG_DDR_STORED,	/* DDR trained and results cached */
+};
+
+extern void boottime_mark(enum boottime_phase phase);
+extern void boottime_flag(enum boottime_flag flag);
+extern u32 boottime_read(u32 *out);
+
+#endif /* _BOOTTIME_H_ */
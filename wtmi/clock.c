@@ -1153,6 +1153,15 @@ void udelay(u32 us)
 	);
 }
 
+/*
+ * The counter at 0xc0008324 is decremented every microsecond. Return it negated
+ * so that the difference of two readings is the elapsed time.
+ */
+u32 get_timer_us(void)
+{
+	return -readl(0xc0008324);
+}
+
 DECL_DEBUG_CMD(cmd_ndelay)
 {
 	u32 ns, start, stop;
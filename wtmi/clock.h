@@ -54,5 +54,6 @@ u32 get_ref_clk(void);
 u32 get_cm3_clk(void);
 void ndelay(u32 ns);
 void udelay(u32 us);
+u32 get_timer_us(void);
 
 #endif /* _CLOCK_H_ */
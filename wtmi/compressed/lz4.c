@@ -0,0 +1,151 @@
+/*
+ * Decoder for the LZ4 frame format, as produced by the lz4 command line tool.
+ * Only what is needed to unpack the embedded secure firmware is supported:
+ * checksums are skipped, not verified (the image is verified as a whole by
+ * BootROM), and dictionaries are not supported.
+ */
+
+#include "lz4.h"
+
+#define LZ4_MAGIC		0x184d2204
+
+#define LZ4_FLG_VERSION_MASK	0xc0
+#define LZ4_FLG_VERSION		0x40
+#define LZ4_FLG_BLOCK_CSUM	0x10
+#define LZ4_FLG_CONTENT_SIZE	0x08
+#define LZ4_FLG_CONTENT_CSUM	0x04
+#define LZ4_FLG_DICT_ID		0x01
+
+#define LZ4_BLOCK_UNCOMPRESSED	0x80000000
+
+static inline u32 get_le32(const u8 *p)
+{
+	return p[0] | (p[1] << 8) | (p[2] << 16) | (p[3] << 24);
+}
+
+/* read the continuation of a literal or match length */
+static int lz4_len(const u8 **srcp, const u8 *end, u32 *len)
+{
+	const u8 *src = *srcp;
+	u8 b;
+
+	do {
+		if (src >= end)
+			return -1;
+		b = *src++;
+		*len += b;
+	} while (b == 255);
+
+	*srcp = src;
+
+	return 0;
+}
+
+static int lz4_block(u8 *base, u8 **dstp, u8 *dst_end, const u8 *src, u32 len)
+{
+	const u8 *end = src + len, *match;
+	u8 *dst = *dstp;
+	u32 n, off;
+	u8 token;
+
+	while (src < end) {
+		token = *src++;
+
+		n = token >> 4;
+		if (n == 15 && lz4_len(&src, end, &n))
+			return -1;
+
+		if (n > end - src || n > dst_end - dst)
+			return -1;
+
+		while (n--)
+			*dst++ = *src++;
+
+		/* the last sequence has only literals */
+		if (src == end)
+			break;
+
+		if (end - src < 2)
+			return -1;
+
+		off = src[0] | (src[1] << 8);
+		src += 2;
+
+		if (!off || off > dst - base)
+			return -1;
+
+		n = token & 15;
+		if (n == 15 && lz4_len(&src, end, &n))
+			return -1;
+		n += 4;
+
+		if (n > dst_end - dst)
+			return -1;
+
+		/* byte by byte, since the match may overlap the output */
+		match = dst - off;
+		while (n--)
+			*dst++ = *match++;
+	}
+
+	*dstp = dst;
+
+	return 0;
+}
+
+int lz4_unpack(void *_dst, u32 dstlen, const u8 *src, u32 *lenp)
+{
+	const u8 *end = src + *lenp;
+	u8 *dst = _dst, *dst_end = dst + dstlen;
+	u32 bsize;
+	u8 flg;
+
+	if (end - src < 7 || get_le32(src) != LZ4_MAGIC)
+		return -1;
+
+	flg = src[4];
+	if ((flg & LZ4_FLG_VERSION_MASK) != LZ4_FLG_VERSION ||
+	    (flg & LZ4_FLG_DICT_ID))
+		return -1;
+
+	/* magic, FLG, BD, optional content size, header checksum */
+	src += 6;
+	if (flg & LZ4_FLG_CONTENT_SIZE)
+		src += 8;
+	++src;
+
+	while (1) {
+		if (end - src < 4)
+			return -1;
+
+		bsize = get_le32(src);
+		src += 4;
+
+		if (!bsize)
+			break;
+
+		if ((bsize & ~LZ4_BLOCK_UNCOMPRESSED) > end - src)
+			return -1;
+
+		if (bsize & LZ4_BLOCK_UNCOMPRESSED) {
+			bsize &= ~LZ4_BLOCK_UNCOMPRESSED;
+			if (bsize > dst_end - dst)
+				return -1;
+
+			while (bsize--)
+				*dst++ = *src++;
+		} else {
+			if (lz4_block(_dst, &dst, dst_end, src, bsize))
+				return -1;
+
+			src += bsize;
+		}
+
+		if (flg & LZ4_FLG_BLOCK_CSUM)
+			src += 4;
+	}
+
+	*lenp = dst - (u8 *)_dst;
+
+	return 0;
+}
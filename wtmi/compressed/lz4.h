@@ -0,0 +1,8 @@
+#ifndef _LZ4_H_
+#define _LZ4_H_
+
+#include "../types.h"
+
+extern int lz4_unpack(void *dst, u32 dstlen, const u8 *src, u32 *lenp);
+
+#endif /* !_LZ4_H_ */
@@ -1,6 +1,18 @@
 #include "types.h"
 #include "irq.h"
 #include "reload.h"
+
+#ifdef COMPRESS_LZ4
+
+#include "lz4.h"
+
+static int unpack(void *dst, u32 dstlen, u8 *src, u32 *lenp)
+{
+	return lz4_unpack(dst, dstlen, src, lenp);
+}
+
+#else /* !COMPRESS_LZ4 */
+
 #include "zlib_defs.h"
 
 int zunzip(void *dst, u32 dstlen, u8 *src, u32 *lenp, int stoponerr, int offset)
@@ -31,12 +43,67 @@ int zunzip(void *dst, u32 dstlen, u8 *src, u32 *lenp, int stoponerr, int offset)
 	return err;
 }
 
+static int unpack(void *dst, u32 dstlen, u8 *src, u32 *lenp)
+{
+	return zunzip(dst, dstlen, src, lenp, 1, 0);
+}
+
+#endif /* !COMPRESS_LZ4 */
+
 static void die(void)
 {
 	while (1)
 		wait_for_irq();
 }
 
+#ifdef COMPRESS_DIRECT
+
+#define DEST_ADDR	0x1fff0000
+#define DEST_SIZE	0x10000
+
+/*
+ * Runs from 0x20000000 (see wtmi_direct.ld), so the secure firmware can be
+ * unpacked directly to its execution address, without staging and the copy
+ * done by the reload helper. It must not be inlined into main(), which runs
+ * from the .startup section that is overwritten here; wtmi_direct.ld checks
+ * that it is placed in the relocated code.
+ */
+void __attribute__((noreturn, noinline, section(".text")))
+unpack_and_run(void)
+{
+	extern u8 compressed_start, compressed_end;
+	void __attribute__((noreturn)) (*jump_to)(void);
+	u32 len;
+
+	len = &compressed_end - &compressed_start;
+
+	/* the vector table is overwritten while unpacking */
+	disable_irq();
+
+	if (unpack((void *)DEST_ADDR, DEST_SIZE, &compressed_start, &len))
+		die();
+
+	jump_to = (void *)(*(u32 *)(DEST_ADDR + 4));
+	jump_to();
+}
+
+/* runs from where BootROM loaded the image, in the .startup section */
+void __attribute__((noreturn, section(".startup"))) main(void)
+{
+	extern u32 relocate_load, relocate_start, relocate_end;
+	u32 *s = &relocate_load, *d = &relocate_start;
+
+	/* memcpy is not relocated yet, keep the compiler from calling it */
+	while (d < &relocate_end) {
+		*d++ = *s++;
+		asm volatile("" ::: "memory");
+	}
+
+	unpack_and_run();
+}
+
+#else /* !COMPRESS_DIRECT */
+
 void __attribute__((noreturn)) main(void)
 {
 	extern u8 compressed_start, compressed_end;
@@ -48,7 +115,7 @@ void __attribute__((noreturn)) main(void)
 	len = &compressed_end - &compressed_start;
 	dst = (void *)0x20000000;
 
-	if (zunzip(dst, 65536, src, &len, 1, 0))
+	if (unpack(dst, 65536, src, &len))
 		die();
 
 	if (len % 4)
@@ -57,3 +124,5 @@ void __attribute__((noreturn)) main(void)
 	do_reload(dst, len);
 	die();
 }
+
+#endif /* !COMPRESS_DIRECT */
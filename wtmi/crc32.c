@@ -67,21 +67,80 @@ static const u32 crc_table[256] = {
 	0xb40bbe37U, 0xc30c8ea1U, 0x5a05df1bU, 0x2d02ef8dU
 };
 
+/*
+ * With slicing-by-N the input is processed N bytes at a time, using N lookup
+ * tables. The first table is the one above, the other N - 1 (1 KiB each) are
+ * computed into .bss on first use. CRC32_SLICES can be 1, 4 or 8.
+ */
+#ifndef CRC32_SLICES
+# define CRC32_SLICES 4
+#endif
+
+#if CRC32_SLICES != 1 && CRC32_SLICES != 4 && CRC32_SLICES != 8
+# error "CRC32_SLICES must be 1, 4 or 8"
+#endif
+
+#if CRC32_SLICES > 1
+static u32 crc_slice_table[CRC32_SLICES - 1][256];
+static int crc_slice_table_ready;
+
+static void crc32_init_slice_table(void)
+{
+	const u32 *prev = crc_table;
+	int i, j;
+
+	for (i = 0; i < CRC32_SLICES - 1; ++i) {
+		for (j = 0; j < 256; ++j)
+			crc_slice_table[i][j] = (prev[j] >> 8) ^
+						crc_table[prev[j] & 0xff];
+		prev = crc_slice_table[i];
+	}
+
+	crc_slice_table_ready = 1;
+}
+
+# define T(n, x)	((n) ? crc_slice_table[(n) - 1][(x) & 0xff] \
+			     : crc_table[(x) & 0xff])
+#endif
+
 u32 crc32(u32 crc, const void *buf, size_t len)
 {
 	const u32 *word;
 
-	while ((((size_t)buf) & 3) && len--)
+#if CRC32_SLICES > 1
+	if (!crc_slice_table_ready)
+		crc32_init_slice_table();
+#endif
+
+	for (; len && (((size_t)buf) & 3); --len)
 		crc = crc_table[(crc ^ *(u8 *)buf++) & 0xff] ^ (crc >> 8);
 
-	for (word = buf; len >= 4; len -= 4) {
+	word = buf;
+
+#if CRC32_SLICES == 8
+	for (; len >= 8; len -= 8) {
+		u32 one = *word++ ^ crc, two = *word++;
+
+		crc = T(7, one) ^ T(6, one >> 8) ^ T(5, one >> 16) ^
+		      T(4, one >> 24) ^ T(3, two) ^ T(2, two >> 8) ^
+		      T(1, two >> 16) ^ T(0, two >> 24);
+	}
+#endif
+
+	for (; len >= 4; len -= 4) {
 		crc ^= *word++;
+#if CRC32_SLICES > 1
+		crc = T(3, crc) ^ T(2, crc >> 8) ^ T(1, crc >> 16) ^
+		      T(0, crc >> 24);
+#else
 		crc = crc_table[crc & 0xff] ^ (crc >> 8);
 		crc = crc_table[crc & 0xff] ^ (crc >> 8);
 		crc = crc_table[crc & 0xff] ^ (crc >> 8);
 		crc = crc_table[crc & 0xff] ^ (crc >> 8);
+#endif
 	}
 
+	buf = word;
 	while (len--)
 		crc = crc_table[(crc ^ *(u8 *)buf++) & 0xff] ^ (crc >> 8);
 
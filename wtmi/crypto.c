@@ -249,6 +249,32 @@ static void bn_addmod(u32 *dst, const u32 *src, const u32 *mod)
 	bn_modulo(dst, mod);
 }
 
+/*
+ * AIB_CTRL and SP_CTRL select which crypto engine is connected to the
+ * accelerator interface bus. Remember the current selection so that it is
+ * not rewritten before every single engine operation.
+ */
+static const struct {
+	u32 aib;
+	u32 sp;
+} crypto_routes[] = {
+	[CRYPTO_ROUTE_HASH]	= { 0x205, 0x00 },
+	[CRYPTO_ROUTE_ECP]	= { 0x250, 0x10 },
+	[CRYPTO_ROUTE_ZMODP]	= { 0x260, 0x10 },
+};
+
+static enum crypto_route cur_route;
+
+void crypto_route(enum crypto_route route)
+{
+	if (route == cur_route)
+		return;
+
+	writel(crypto_routes[route].aib, AIB_CTRL);
+	setbitsl(SP_CTRL, crypto_routes[route].sp, 0x30);
+	cur_route = route;
+}
+
 static inline u32 ecp_wait(void)
 {
 	u32 val;
@@ -262,28 +288,29 @@ static inline u32 ecp_wait(void)
 	return val;
 }
 
-static inline void ecp_init(void)
+/* whether curve parameters A and B are loaded in ECP engine */
+static int ecp_curve_loaded;
+
+static void ecp_zeroize(void)
 {
-	writel(0x250, AIB_CTRL);
-	setbitsl(SP_CTRL, 0x10, 0x30);
+	crypto_route(CRYPTO_ROUTE_ECP);
 	writel(ECP_CONF_FLD_521 | ECP_CONF_OP_ZERO, ECP_CONF);
 	writel(0x1, ECP_CMD);
 	ecp_wait();
+	ecp_curve_loaded = 0;
 }
 
 static void ecp_secp521r1_init(void)
 {
-	ecp_init();
+	if (ecp_curve_loaded) {
+		crypto_route(CRYPTO_ROUTE_ECP);
+		return;
+	}
+
+	ecp_zeroize();
 	bn_copy(ECP_PARAM_A, secp521r1.curve.a);
 	bn_copy(ECP_PARAM_B, secp521r1.curve.b);
-}
-
-static void ecp_clear_operands(void)
-{
-	bn_from_u32(ECP_OP1_X, 0);
-	bn_from_u32(ECP_OP1_Y, 0);
-	bn_from_u32(ECP_OP2_X, 0);
-	bn_from_u32(ECP_OP2_Y, 0);
+	ecp_curve_loaded = 1;
 }
 
 static int ecp_secp521r1_add(ec_point_t *r, const ec_point_t *a,
@@ -347,15 +374,17 @@ static int ecp_secp521r1_point_mul_by_otp(ec_point_t *r, const ec_point_t *a)
 	       ECP_CONF);
 	writel(0x1, ECP_CMD);
 
-	if (ecp_wait() & (ECP_INT_ZERO_OUTPUT | ECP_INT_CAL_ZERO_INV))
-		return -EDOM;
-
-	if (r) {
+	if (ecp_wait() & (ECP_INT_ZERO_OUTPUT | ECP_INT_CAL_ZERO_INV)) {
+		res = -EDOM;
+	} else if (r) {
 		bn_copy(r->x, ECP_RES_X);
 		bn_copy(r->y, ECP_RES_Y);
 	}
 
-	return 0;
+	/* the engine worked with the private key, clear it */
+	ecp_zeroize();
+
+	return res;
 }
 
 static inline u32 zmodp_wait(void)
@@ -371,19 +400,26 @@ static inline u32 zmodp_wait(void)
 	return val;
 }
 
-void zmodp_zeroize(void)
+static int zmodp_bits, zmodp_longs, zmodp_pad;
+
+static void zmodp_zeroize(void)
 {
+	crypto_route(CRYPTO_ROUTE_ZMODP);
 	writel(ZMODP_CMD_ZEROIZE, ZMODP_CMD);
 	zmodp_wait();
-}
 
-static int zmodp_longs, zmodp_pad;
+	zmodp_bits = 0;
+}
 
 static int zmodp_set_size(int bits)
 {
 	if (bits > 2048)
 		return -EINVAL;
 
+	if (bits == zmodp_bits)
+		return 0;
+
+	zmodp_bits = bits;
 	zmodp_longs = (bits + 31) / 32;
 
 	if (bits < 128)
@@ -430,8 +466,7 @@ static inline int zmodp_op(u32 op, u32 *res, const u32 *x, const u32 *y,
 		reg |= ZMODP_CONF_X_FROM_OTP;
 	}
 
-	writel(0x260, AIB_CTRL);
-	setbitsl(SP_CTRL, 0x10, 0x30);
+	crypto_route(CRYPTO_ROUTE_ZMODP);
 	setbitsl(ZMODP_CONF, reg,
 		 ZMODP_CONF_SECURE | ZMODP_CONF_OP_MASK |
 		 ZMODP_CONF_X_FROM_OTP);
@@ -444,6 +479,10 @@ static inline int zmodp_op(u32 op, u32 *res, const u32 *x, const u32 *y,
 			writel(0, (dst));		\
 	} while (0)
 
+	/*
+	 * ZMODP_MODULI is a FIFO port and it is not known whether the engine
+	 * keeps the modulus and R across operations, upload them every time.
+	 */
 	copy_words(ZMODP_MODULI, zmodp_prime->p);
 
 	if (op != ZMODP_CONF_OP_PRE) {
@@ -521,51 +560,185 @@ int ecdsa_generate_efuse_private_key(void)
 	return res;
 }
 
-int ecdsa_sign(ec_sig_t *sig, const u32 *z)
+/*
+ * Pool of precomputed (k^-1, r) pairs for ECDSA signing. The expensive part of
+ * signing (generating the nonce k and computing r from k * G) does not depend
+ * on the message, so it is done in the main loop while idle, and a sign request
+ * then only needs two ZMODP multiplications.
+ */
+#define ECDSA_POOL_SIZE		4
+#define ECDSA_LAT_SAMPLES	64
+
+typedef struct {
+	u32 kinv[17];
+	u32 r[17];
+} ecdsa_nonce_t;
+
+static ecdsa_nonce_t ecdsa_pool[ECDSA_POOL_SIZE];
+static int ecdsa_pool_len;
+
+static u32 ecdsa_pool_hits, ecdsa_pool_misses;
+static u32 ecdsa_lat[ECDSA_LAT_SAMPLES];
+static int ecdsa_lat_cnt, ecdsa_lat_pos;
+
+static void ecdsa_nonce_zeroize(ecdsa_nonce_t *n)
+{
+	bn_from_u32(n->kinv, 0);
+	bn_from_u32(n->r, 0);
+}
+
+static int ecdsa_gen_nonce(ecdsa_nonce_t *n)
 {
-	int res;
 	ec_point_t p;
 	u32 k[17];
+	int res;
 
-	/* is message too long */
-	if (z[16] > 0x1ff)
-		return -EINVAL;
+	do {
+		do
+			bn_random(k, secp521r1.order.p, 521);
+		while (bn_is_zero(k));
+
+		ecp_secp521r1_point_mul(&p, &secp521r1.base, k);
+		ecp_zeroize();
+
+		bn_copy(n->r, p.x);
+		bn_modulo(n->r, secp521r1.order.p);
+	} while (bn_is_zero(n->r));
 
 	zmodp_set_size(secp521r1.bits);
 	zmodp_set_prime(&secp521r1.order);
 
+	res = zmodp_op(ZMODP_CONF_OP_INV, n->kinv, k, NULL, CLEAR_X);
+
+	bn_from_u32(k, 0);
+	bn_from_u32(p.y, 0);
+
+	return res;
+}
+
+void ecdsa_process(void)
+{
+	if (ecdsa_pool_len == ECDSA_POOL_SIZE)
+		return;
+
+	if (ecdsa_gen_nonce(&ecdsa_pool[ecdsa_pool_len]) < 0)
+		ecdsa_nonce_zeroize(&ecdsa_pool[ecdsa_pool_len]);
+	else
+		++ecdsa_pool_len;
+}
+
+void crypto_zeroize(void)
+{
+	ecp_zeroize();
+	zmodp_zeroize();
+}
+
+void ecdsa_pool_zeroize(void)
+{
+	int i;
+
+	for (i = 0; i < ECDSA_POOL_SIZE; ++i)
+		ecdsa_nonce_zeroize(&ecdsa_pool[i]);
+
+	ecdsa_pool_len = 0;
+}
+
+static int ecdsa_get_nonce(ecdsa_nonce_t *n)
+{
+	ecdsa_nonce_t *top;
+
+	if (!ecdsa_pool_len) {
+		++ecdsa_pool_misses;
+		return ecdsa_gen_nonce(n);
+	}
+
+	++ecdsa_pool_hits;
+	top = &ecdsa_pool[--ecdsa_pool_len];
+	bn_copy(n->kinv, top->kinv);
+	bn_copy(n->r, top->r);
+	ecdsa_nonce_zeroize(top);
+
+	return 0;
+}
+
+static int _ecdsa_sign(ec_sig_t *sig, const u32 *z)
+{
+	ecdsa_nonce_t n;
+	int res;
+
 	do {
-		do {
-			do
-				bn_random(k, secp521r1.order.p, 521);
-			while (bn_is_zero(k));
+		res = ecdsa_get_nonce(&n);
+		if (res < 0)
+			break;
 
-			ecp_secp521r1_point_mul(&p, &secp521r1.base, k);
-			ecp_clear_operands();
+		zmodp_set_size(secp521r1.bits);
+		zmodp_set_prime(&secp521r1.order);
 
-			bn_copy(sig->r, p.x);
-			bn_modulo(sig->r, secp521r1.order.p);
-		} while (bn_is_zero(sig->r));
+		bn_copy(sig->r, n.r);
 
 		res = zmodp_op(ZMODP_CONF_OP_MUL, sig->s, NULL, sig->r,
 			       X_FROM_OTP);
 		if (res < 0)
-			return res;
-
-		res = zmodp_op(ZMODP_CONF_OP_INV, k, k, NULL, CLEAR_X);
-		if (res < 0)
-			return res;
+			break;
 
 		bn_addmod(sig->s, z, secp521r1.order.p);
 
-		res = zmodp_op(ZMODP_CONF_OP_MUL, sig->s, k, sig->s, CLEAR_X);
+		res = zmodp_op(ZMODP_CONF_OP_MUL, sig->s, n.kinv, sig->s,
+			       CLEAR_X);
 		if (res < 0)
-			return res;
+			break;
 	} while (bn_is_zero(sig->s));
 
-	bn_from_u32(k, 0);
+	ecdsa_nonce_zeroize(&n);
 
-	return 0;
+	return res;
+}
+
+int ecdsa_sign(ec_sig_t *sig, const u32 *z)
+{
+	u32 start;
+	int res;
+
+	/* is message too long */
+	if (z[16] > 0x1ff)
+		return -EINVAL;
+
+	start = get_timer_us();
+	res = _ecdsa_sign(sig, z);
+
+	ecdsa_lat[ecdsa_lat_pos] = get_timer_us() - start;
+	ecdsa_lat_pos = (ecdsa_lat_pos + 1) % ECDSA_LAT_SAMPLES;
+	if (ecdsa_lat_cnt < ECDSA_LAT_SAMPLES)
+		++ecdsa_lat_cnt;
+
+	return res;
+}
+
+void ecdsa_get_sign_stats(ecdsa_sign_stats_t *stats)
+{
+	u32 lat[ECDSA_LAT_SAMPLES], t;
+	int i, j;
+
+	stats->pool_depth = ecdsa_pool_len;
+	stats->pool_size = ECDSA_POOL_SIZE;
+	stats->hits = ecdsa_pool_hits;
+	stats->misses = ecdsa_pool_misses;
+
+	if (!ecdsa_lat_cnt) {
+		stats->lat_p50 = stats->lat_p99 = 0;
+		return;
+	}
+
+	/* insertion sort of the latency samples */
+	for (i = 0; i < ecdsa_lat_cnt; ++i) {
+		t = ecdsa_lat[i];
+		for (j = i; j > 0 && lat[j - 1] > t; --j)
+			lat[j] = lat[j - 1];
+		lat[j] = t;
+	}
+
+	stats->lat_p50 = lat[(ecdsa_lat_cnt - 1) * 50 / 100];
+	stats->lat_p99 = lat[(ecdsa_lat_cnt - 1) * 99 / 100];
 }
 
 static inline int ecdsa_valid_scalar(const u32 *x)
@@ -644,7 +817,8 @@ DECL_DEBUG_CMD(cmd_ecdsa)
 {
 	ec_point_t pub;
 	ec_sig_t sig;
-	u32 z[17];
+	u32 z[17], start, sign_us, verify_us;
+	int res;
 
 	bn_random(z, secp521r1.order.p, 521);
 
@@ -652,7 +826,9 @@ DECL_DEBUG_CMD(cmd_ecdsa)
 	bn_print(z);
 	printf("\n");
 
+	start = get_timer_us();
 	ecdsa_sign(&sig, z);
+	sign_us = get_timer_us() - start;
 	printf("Signature:\n");
 	bn_print(sig.r);
 	bn_print(sig.s);
@@ -664,11 +840,32 @@ DECL_DEBUG_CMD(cmd_ecdsa)
 	bn_print(pub.y);
 	printf("\n");
 
-	printf("Verification status: %d\n", ecdsa_verify(&pub, &sig, z));
+	start = get_timer_us();
+	res = ecdsa_verify(&pub, &sig, z);
+	verify_us = get_timer_us() - start;
+
+	printf("Verification status: %d\n", res);
+	printf("Signing took %u us, verification took %u us\n", sign_us,
+	       verify_us);
 }
 
 DEBUG_CMD("ecdsa", "Test ECDSA cryptographic engine", cmd_ecdsa);
 
+DECL_DEBUG_CMD(cmd_ecdsa_stats)
+{
+	ecdsa_sign_stats_t stats;
+
+	ecdsa_get_sign_stats(&stats);
+
+	printf("Nonce pool: %u/%u filled\n", stats.pool_depth,
+	       stats.pool_size);
+	printf("Nonce pool hits: %u, misses: %u\n", stats.hits, stats.misses);
+	printf("Sign latency: p50 %u us, p99 %u us\n", stats.lat_p50,
+	       stats.lat_p99);
+}
+
+DEBUG_CMD("ecdsa_stats", "Show ECDSA signing statistics", cmd_ecdsa_stats);
+
 DECL_DEBUG_CMD(cmd_gen_ecdsa_key)
 {
 	if (ecdsa_generate_efuse_private_key())
@@ -31,12 +31,33 @@ typedef struct {
 	prime_t order;
 } ec_info_t;
 
+enum crypto_route {
+	CRYPTO_ROUTE_NONE = 0,
+	CRYPTO_ROUTE_HASH,
+	CRYPTO_ROUTE_ECP,
+	CRYPTO_ROUTE_ZMODP,
+};
+
+typedef struct {
+	u32 pool_depth;
+	u32 pool_size;
+	u32 hits;
+	u32 misses;
+	u32 lat_p50;
+	u32 lat_p99;
+} ecdsa_sign_stats_t;
+
+extern void crypto_route(enum crypto_route route);
+extern void crypto_zeroize(void);
 extern int bn_add(u32 *dst, const u32 *src, int len);
 extern int ecdsa_sign(ec_sig_t *sig, const u32 *z);
 extern int ecdsa_verify(const ec_point_t *pub, const ec_sig_t *sig,
 			const u32 *z);
 extern int ecdsa_generate_efuse_private_key(void);
 extern int ecdsa_get_efuse_public_key(u32 *compressed_pub);
+extern void ecdsa_process(void);
+extern void ecdsa_pool_zeroize(void);
+extern void ecdsa_get_sign_stats(ecdsa_sign_stats_t *stats);
 extern void test_ecp(void);
 
 #endif /* _CRYPTO_H_ */
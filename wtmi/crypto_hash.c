@@ -2,15 +2,13 @@
 #include "types.h"
 #include "io.h"
 #include "clock.h"
+#include "crypto.h"
 #include "crypto_hash.h"
 #include "crypto_dma.h"
 #include "string.h"
+#include "div64.h"
 #include "debug.h"
 
-#define AIB_CTRL	0x40000c00
-#define SP_CTRL		0x40001c00
-#define SP_STATUS	0x40001c04
-
 #define HASH_CONF		0x40001800
 #define HASH_CONF_AES_COMBINE	BIT(4)
 #define HASH_CONF_MODE_HMAC	BIT(3)
@@ -53,8 +51,7 @@ static inline void hash_wait(void)
 
 static void hash_init(u32 alg, u32 size)
 {
-	writel(0x205, AIB_CTRL);
-	setbitsl(SP_CTRL, 0x00, 0x30);
+	crypto_route(CRYPTO_ROUTE_HASH);
 	writel(HASH_CTRL_RESET, HASH_CTRL);
 	writel(HASH_CTRL_PADDING, HASH_CTRL);
 	writel(alg & HASH_CONF_ALG_MASK, HASH_CONF);
@@ -66,8 +63,13 @@ static void hash_init(u32 alg, u32 size)
 	hash_wait();
 }
 
-static void hash_update(const void *data, u32 size, int final)
+static void hash_update_start(const void *data, u32 size, int final)
 {
+	/*
+	 * Commands handled between slices of a hash job may route the
+	 * accelerator bus to another engine.
+	 */
+	crypto_route(CRYPTO_ROUTE_HASH);
 	dma_input_enable(data, size);
 	writel(size, HASH_MSG_SEG_SZ);
 	if (final) {
@@ -78,10 +80,20 @@ static void hash_update(const void *data, u32 size, int final)
 		setbitsl(HASH_CTRL, HASH_CTRL_OP_UPDATE, HASH_CTRL_OP_MASK);
 	}
 	writel(HASH_CMD_START, HASH_CMD);
+}
+
+static void hash_update_wait(void)
+{
 	hash_wait();
 	dma_input_disable();
 }
 
+static void hash_update(const void *data, u32 size, int final)
+{
+	hash_update_start(data, size, final);
+	hash_update_wait();
+}
+
 static void hash_final(u32 *digest, int d)
 {
 	int i;
@@ -141,6 +153,151 @@ void hw_sha512(const void *msg, u32 size, u32 *digest)
 	hash_final(digest, 16);
 }
 
+static const struct {
+	u32 alg;
+	u8 dlen;
+	u8 block;
+} hash_algs[] = {
+	[HASH_MD5]	= { HASH_CONF_ALG_MD5, 4, 64 },
+	[HASH_SHA1]	= { HASH_CONF_ALG_SHA1, 5, 64 },
+	[HASH_SHA224]	= { HASH_CONF_ALG_SHA224, 7, 64 },
+	[HASH_SHA256]	= { HASH_CONF_ALG_SHA256, 8, 64 },
+	[HASH_SHA384]	= { HASH_CONF_ALG_SHA384, 12, 128 },
+	[HASH_SHA512]	= { HASH_CONF_ALG_SHA512, 16, 128 },
+};
+
+/*
+ * Streaming hash API. The total message size has to be known in advance,
+ * since the engine needs it for padding. The message can then be passed in
+ * arbitrarily sized and aligned segments: whole blocks are fed to the engine
+ * by DMA directly from the source, only partial blocks and unaligned data go
+ * through the block buffer in the context.
+ *
+ * The engine state is not saved in the context, therefore only one hash may
+ * be in progress at a time and no other hash function may be called between
+ * hw_hash_init() and hw_hash_final(). Code running in the background can check
+ * this with hw_hash_busy().
+ */
+static int hash_stream_active;
+
+int hw_hash_busy(void)
+{
+	return hash_stream_active;
+}
+
+int hw_hash_init(hash_ctx_t *ctx, int id, u32 size)
+{
+	if (id <= HASH_NA || id >= ARRAY_SIZE(hash_algs))
+		return -EINVAL;
+
+	ctx->id = id;
+	ctx->buflen = 0;
+	hash_stream_active = 1;
+
+	hash_init(hash_algs[id].alg, size);
+
+	return 0;
+}
+
+void hw_hash_update(hash_ctx_t *ctx, const void *data, u32 size)
+{
+	u32 block = hash_algs[ctx->id].block;
+	u32 n;
+
+	while (size) {
+		/*
+		 * A full buffer is only flushed when more data arrives, since
+		 * the last block has to be sent with the final operation.
+		 */
+		if (ctx->buflen == block) {
+			hash_update(ctx->buf, block, 0);
+			ctx->buflen = 0;
+		}
+
+		if (!ctx->buflen && !((u32)data & 3) && size > block) {
+			n = (size - 1) / block * block;
+			hash_update(data, n, 0);
+		} else {
+			n = MIN(size, block - ctx->buflen);
+			memcpy((u8 *)ctx->buf + ctx->buflen, data, n);
+			ctx->buflen += n;
+		}
+
+		data += n;
+		size -= n;
+	}
+}
+
+/*
+ * Like hw_hash_update(), but for a word aligned segment that is a whole number
+ * of blocks (and is not the last segment) it only starts the engine and
+ * returns, so that the CPU can prepare the next segment meanwhile. The segment
+ * must not be changed until hw_hash_update_wait() is called, which has to be
+ * done before any other hash function.
+ */
+static int hash_update_pending;
+
+void hw_hash_update_start(hash_ctx_t *ctx, const void *data, u32 size)
+{
+	u32 block = hash_algs[ctx->id].block;
+
+	if (ctx->buflen || ((u32)data & 3) || !size || size % block) {
+		hw_hash_update(ctx, data, size);
+		return;
+	}
+
+	hash_update_start(data, size, 0);
+	hash_update_pending = 1;
+}
+
+void hw_hash_update_wait(void)
+{
+	if (!hash_update_pending)
+		return;
+
+	hash_update_wait();
+	hash_update_pending = 0;
+}
+
+int hw_hash_final(hash_ctx_t *ctx, u32 *digest)
+{
+	int dlen = hash_algs[ctx->id].dlen;
+
+	hash_update(ctx->buf, ctx->buflen, 1);
+	hash_final(digest, dlen);
+
+	bzero(ctx->buf, sizeof(ctx->buf));
+	ctx->buflen = 0;
+	hash_stream_active = 0;
+
+	return dlen;
+}
+
+/*
+ * Asynchronous one-shot hashing: hw_hash_start() starts hashing the message and
+ * returns immediately, so that the CPU can do something else while the engine
+ * works. hw_hash_finish() waits for the digest. The message must not be changed
+ * in between, and no other hash function may be called.
+ */
+static int async_id;
+
+void hw_hash_start(int id, const void *msg, u32 size)
+{
+	async_id = id;
+	hash_init(hash_algs[id].alg, size);
+	hash_update_start(msg, size, 1);
+}
+
+int hw_hash_finish(u32 *digest)
+{
+	int dlen = hash_algs[async_id].dlen;
+
+	hash_update_wait();
+	hash_final(digest, dlen);
+
+	return dlen;
+}
+
 DECL_DEBUG_CMD(cmd_hash_specific)
 {
 	u32 digest[16];
@@ -178,6 +335,15 @@ DEBUG_CMD("sha256", "SHA256 hash", cmd_hash_specific);
 DEBUG_CMD("sha384", "SHA384 hash", cmd_hash_specific);
 DEBUG_CMD("sha512", "SHA512 hash", cmd_hash_specific);
 
+static const char * const hash_names[] = {
+	[HASH_MD5]	= "md5",
+	[HASH_SHA1]	= "sha1",
+	[HASH_SHA224]	= "sha224",
+	[HASH_SHA256]	= "sha256",
+	[HASH_SHA384]	= "sha384",
+	[HASH_SHA512]	= "sha512",
+};
+
 static int digestcmp(const u32 *x, const u32 *y, int l)
 {
 	while (l--)
@@ -214,9 +380,19 @@ static void test_hash(void)
 		0x29d32e7e, 0xf989ca74, 0xb3c09291, 0x70294d68, 0xc12fce64,
 		0x93554c88
 	};
+	static const u32 *test_digests[] = {
+		[HASH_MD5]	= test_md5,
+		[HASH_SHA1]	= test_sha1,
+		[HASH_SHA224]	= test_sha224,
+		[HASH_SHA256]	= test_sha256,
+		[HASH_SHA384]	= test_sha384,
+		[HASH_SHA512]	= test_sha512,
+	};
+	static const u32 seg_sizes[] = { 1, 3, 64, 127, 129, 500, 1021 };
 	static u32 msg[1024] __attribute__((aligned(16)));
-	u32 dig[16];
-	int i;
+	hash_ctx_t ctx;
+	u32 dig[16], pos, seg;
+	int i, id, dlen;
 
 	for(i = 0; i < sizeof(msg) / sizeof(*msg); ++i)
 		msg[i] = i + 0x1234beef;
@@ -238,10 +414,55 @@ static void test_hash(void)
 	TEST(sha256, 8);
 	TEST(sha384, 12);
 	TEST(sha512, 16);
+
+	printf("Testing streaming hardware hashing:\n");
+
+	for (id = HASH_MD5; id <= HASH_SHA512; ++id) {
+		for (i = 0; i < ARRAY_SIZE(seg_sizes); ++i) {
+			hw_hash_init(&ctx, id, sizeof(msg) - 1);
+			for (pos = 0; pos < sizeof(msg) - 1; pos += seg) {
+				seg = MIN(seg_sizes[i], sizeof(msg) - 1 - pos);
+				hw_hash_update(&ctx, (u8 *)msg + pos, seg);
+			}
+			dlen = hw_hash_final(&ctx, dig);
+
+			if (digestcmp(dig, test_digests[id], dlen))
+				break;
+		}
+
+		if (i < ARRAY_SIZE(seg_sizes))
+			printf("%s streaming failed with %u byte segments\n",
+			       hash_names[id], seg_sizes[i]);
+		else
+			printf("%s streaming success\n", hash_names[id]);
+	}
+}
+
+static void bench_hash(u32 addr, u32 len)
+{
+	hash_ctx_t ctx;
+	u32 dig[16], start, us;
+	u64 rate;
+	int id;
+
+	for (id = HASH_MD5; id <= HASH_SHA512; ++id) {
+		start = get_timer_us();
+		hw_hash_init(&ctx, id, len);
+		hw_hash_update(&ctx, (void *)addr, len);
+		hw_hash_final(&ctx, dig);
+		us = get_timer_us() - start;
+
+		rate = (u64)len * 1000000;
+		do_div(rate, MAX(us, 1U));
+
+		printf("%s: %u bytes in %u us, %llu KiB/s\n", hash_names[id],
+		       len, us, rate >> 10);
+	}
 }
 
 DECL_DEBUG_CMD(cmd_hash)
 {
+	u32 addr, len;
 	int id;
 
 	if (argc < 2)
@@ -250,6 +471,16 @@ DECL_DEBUG_CMD(cmd_hash)
 	if (!strcmp(argv[1], "test"))
 		return test_hash();
 
+	if (!strcmp(argv[1], "bench")) {
+		if (argc != 4)
+			goto usage;
+
+		if (number(argv[2], &addr) || number(argv[3], &len))
+			return;
+
+		return bench_hash(addr, len);
+	}
+
 	if (argc != 4)
 		goto usage;
 
@@ -260,6 +491,7 @@ DECL_DEBUG_CMD(cmd_hash)
 	return cmd_hash_specific(argc - 1, argv + 1);
 usage:
 	printf("usage: hash test\n");
+	printf("       hash bench <addr> <len>\n");
 	printf("       hash <md5|sha1|sha224|sha256|sha384|sha512> <addr> <len>\n");
 }
 
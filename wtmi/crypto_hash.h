@@ -23,6 +23,21 @@ enum {
 	HASH_SHA512,
 };
 
+typedef struct {
+	int id;
+	u32 buflen;
+	u32 buf[32];
+} hash_ctx_t;
+
+extern void hw_hash_start(int id, const void *msg, u32 size);
+extern int hw_hash_finish(u32 *digest);
+extern int hw_hash_busy(void);
+extern int hw_hash_init(hash_ctx_t *ctx, int id, u32 size);
+extern void hw_hash_update(hash_ctx_t *ctx, const void *data, u32 size);
+extern void hw_hash_update_start(hash_ctx_t *ctx, const void *data, u32 size);
+extern void hw_hash_update_wait(void);
+extern int hw_hash_final(hash_ctx_t *ctx, u32 *digest);
+
 static inline int hash_id(const char *name)
 {
 	if (!strcmp(name, "md5"))
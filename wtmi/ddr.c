@@ -35,6 +35,11 @@
 #include "io.h"
 #include "clock.h"
 #include "avs.h"
+#include "board.h"
+#include "boottime.h"
+#include "ddr_cache.h"
+#include "errno.h"
+#include "mbox.h"
 #include "ddr/ddrcore.h"
 #include "string.h"
 #include "stdio.h"
@@ -100,6 +105,33 @@ void rwtm_win_remap(u32 win, u32 remap_addr)
 	setbitsl(CM3_WIN_CONROL(win), BIT(0), BIT(0));
 }
 
+static int cs_reg_to_ram_size(u32 addr)
+{
+	u32 reg = readl(addr);
+
+	if (!(reg & 0x1))
+		return 0;
+
+	reg = (reg >> 16) & 0x1f;
+	if (reg >= 7)
+		return 1 << (reg - 4);
+	else
+		return (1 << reg) * 384;
+}
+
+int get_ram_size(void)
+{
+	static int ram_size;
+
+	if (ram_size)
+		return ram_size;
+
+	ram_size = cs_reg_to_ram_size(0xc0000200) +
+		   cs_reg_to_ram_size(0xc0000208);
+
+	return ram_size;
+}
+
 static u32 do_checksum32(u32 *start, u32 len)
 {
 	u32 sum = 0;
@@ -123,11 +155,46 @@ static int sys_check_warm_boot(void)
 	return 0;
 }
 
+/*
+ * Cold boot DDR init. Training results cached in SPI NOR are restored the same
+ * way as on warm boot, but have to pass a memory test. Otherwise, or if there
+ * are none, full training is done and its results are cached.
+ */
+static int init_ddr_cold(struct ddr_init_para ddr_para,
+			 struct ddr_init_result *result,
+			 const struct ddr_cache_key *key)
+{
+	struct ddr_telemetry telemetry;
+	int ret;
+
+	if (!ddr_cache_load(key, result, &telemetry)) {
+		ddr_para.warm_boot = 1;
+		ret = init_ddr(ddr_para, result);
+		if (!ret && !ddr_cache_test(&ddr_para, key->cs_num)) {
+			/* report the training the cached results come from */
+			ddr_telemetry = telemetry;
+			ddr_telemetry.flags |= DDR_TELEMETRY_CACHED;
+			boottime_flag(BOOTTIME_FLAG_DDR_CACHED);
+			return 0;
+		}
+
+		debug("cached DDR training results failed, retraining\n");
+		ddr_para.warm_boot = 0;
+	}
+
+	ret = init_ddr(ddr_para, result);
+	if (!ret && !ddr_cache_store(key, result, &ddr_telemetry))
+		boottime_flag(BOOTTIME_FLAG_DDR_STORED);
+
+	return ret;
+}
+
 int ddr_main(enum clk_preset WTMI_CLOCK, int DDR_TYPE, int BUS_WIDTH, int SPEED_BIN, int CS_NUM, int DEV_CAP)
 {
 	struct ddr_topology map;
 	struct ddr_init_para ddr_para;
 	struct ddr_init_result *result_in_dram, result_in_sram;
+	struct ddr_cache_key cache_key;
 	u32 chksum_in_dram = 0;
 	int ret;
 
@@ -284,10 +351,27 @@ int ddr_main(enum clk_preset WTMI_CLOCK, int DDR_TYPE, int BUS_WIDTH, int SPEED_
 	* may access DRAM memory, store the result in sram first, and copy to reserved dram
 	* after init_ddr function
 	*/
-	if (ddr_para.warm_boot)
+	/* DDR init needs the voltage set by AVS */
+	avs_complete();
+	boottime_mark(BOOTTIME_AVS);
+
+	if (ddr_para.warm_boot) {
 		ret = init_ddr(ddr_para, result_in_dram);
-	else
-		ret = init_ddr(ddr_para, &result_in_sram);
+		ddr_telemetry.flags |= DDR_TELEMETRY_WARM_BOOT;
+	} else {
+		memset(&cache_key, 0, sizeof(cache_key));
+		cache_key.board     = get_board();
+		cache_key.ddr_type  = DDR_TYPE;
+		cache_key.ram_size  = get_ram_size();
+		cache_key.cs_num    = CS_NUM;
+		cache_key.speed_bin = SPEED_BIN;
+		cache_key.clock     = WTMI_CLOCK;
+
+		ret = init_ddr_cold(ddr_para, &result_in_sram, &cache_key);
+	}
+
+	if (ret)
+		ddr_telemetry.flags |= DDR_TELEMETRY_FAILED;
 
 	/* Copy tuning result to reserved memory */
 	if (!ddr_para.warm_boot) {
@@ -299,29 +383,22 @@ int ddr_main(enum clk_preset WTMI_CLOCK, int DDR_TYPE, int BUS_WIDTH, int SPEED_
 	return ret;
 }
 
-static int cs_reg_to_ram_size(u32 addr)
-{
-	u32 reg = readl(addr);
-
-	if (!(reg & 0x1))
-		return 0;
-
-	reg = (reg >> 16) & 0x1f;
-	if (reg >= 7)
-		return 1 << (reg - 4);
-	else
-		return (1 << reg) * 384;
-}
+_Static_assert(sizeof(struct ddr_telemetry) == 64,
+	       "struct ddr_telemetry layout is part of the mailbox interface");
+_Static_assert(sizeof(struct ddr_telemetry) <= MBOX_MAX_ARGS * sizeof(u32),
+	       "struct ddr_telemetry does not fit into mailbox output arguments");
 
-int get_ram_size(void)
+/*
+ * Copy the telemetry record of the last DDR init to out, which has to have
+ * room for MBOX_MAX_ARGS words. Returns number of words or -ENODATA if DDR
+ * was not initialized.
+ */
+int ddr_telemetry_read(u32 *out)
 {
-	static int ram_size;
-
-	if (ram_size)
-		return ram_size;
+	if (ddr_telemetry.version != DDR_TELEMETRY_VERSION)
+		return -ENODATA;
 
-	ram_size = cs_reg_to_ram_size(0xc0000200) +
-		   cs_reg_to_ram_size(0xc0000208);
+	memcpy(out, &ddr_telemetry, sizeof(ddr_telemetry));
 
-	return ram_size;
+	return sizeof(ddr_telemetry) / 4;
 }
@@ -14,5 +14,6 @@ extern int ddr_main(enum clk_preset WTMI_CLOCK, int DDR_TYPE, int BUS_WIDTH,
 		    int SPEED_BIN, int CS_NUM, int DEV_CAP);
 
 extern int get_ram_size(void);
+extern int ddr_telemetry_read(u32 *out);
 
 #endif /* _DDR_H_ */
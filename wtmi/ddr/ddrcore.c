@@ -34,6 +34,7 @@
 
 #include "ddr.h"
 #include "ddr_support.h"
+#include "../string.h"
 
 #undef VALIDATION_EYE
 
@@ -125,6 +126,7 @@ enum ddr_type tc_ddr_type;
 unsigned int tc_cs_num;
 int debug_level = 0;
 int debug_module = 0;
+struct ddr_telemetry ddr_telemetry;
 
 int set_ddr_type(enum ddr_type type){
 	if(type >= DDR_TYPE_MAX)
@@ -159,6 +161,14 @@ int init_ddr(struct ddr_init_para init_para,
 	debug_level = init_para.log_level;
 	debug_module = init_para.flags;
 
+	memset(&ddr_telemetry, 0, sizeof(ddr_telemetry));
+	memset(ddr_telemetry.qs_cycle, 0xff, sizeof(ddr_telemetry.qs_cycle));
+	memset(ddr_telemetry.qs_tap, 0xff, sizeof(ddr_telemetry.qs_tap));
+	ddr_telemetry.version = DDR_TELEMETRY_VERSION;
+	ddr_telemetry.size = sizeof(ddr_telemetry);
+	ddr_telemetry.ddr_type = tc_ddr_type;
+	ddr_telemetry.cs_num = tc_cs_num;
+
 	/* Write patterns at slow speed before going into Self Refresh */
 	//TODO: ddr_test_dma(0x1000) - size, base addr - Is it needed if I do self_refresh_test(0)
 
@@ -292,6 +302,7 @@ int init_ddr(struct ddr_init_para init_para,
 		}
 		LogMsg(LOG_LEVEL_INFO, FLAG_REGS_QS_GATE, "\nAfter QS gating:");
 		logs_training_regs(QS_GATE);
+		ddr_telemetry.flags |= DDR_TELEMETRY_QS_DONE;
 	}
 #endif
 
@@ -305,6 +316,7 @@ int init_ddr(struct ddr_init_para init_para,
 		LogMsg(LOG_LEVEL_INFO, FLAG_REGS_VREF_READ, "\nBefore vref read training:");
 		logs_training_regs(VREF_READ);
 		vdac_value = vref_read_training(tc_cs_num, init_para);
+		ddr_telemetry.flags |= DDR_TELEMETRY_VREF_DONE;
 		if (vdac_value >= 0) {/*training passed*/
 			LogMsg(LOG_LEVEL_ERROR, FLAG_REGS_VREF_READ, "\nVREF READ TRAINING PASSED");
 			LogMsg(LOG_LEVEL_INFO, FLAG_REGS_VREF_READ, "\nFinal vdac_value 0x%02X\n", vdac_value);
@@ -355,6 +367,7 @@ int init_ddr(struct ddr_init_para init_para,
 	LogMsg(LOG_LEVEL_INFO, FLAG_REGS_DLL_TUNE, "\nBefore DLL tuning:");
 	logs_training_regs(DLL_TUNE);
 	dll_res = dll_tuning(2, tc_cs_num, &init_para, false, true);
+	ddr_telemetry.flags |= DDR_TELEMETRY_DLL_DONE;
 	if (dll_res > 0) {
 		result->dll_tune.dll_ctrl_b0 =
 			ll_read32(CH0_PHY_DLL_control_B0);
@@ -112,6 +112,60 @@ struct ddr_init_result {
 	};
 };
 
+/*
+ * Training telemetry handed to the AP by MBOX_CMD_DDR_TELEMETRY. The layout is
+ * part of the interface (see ddr-telemetry.py), bump DDR_TELEMETRY_VERSION
+ * when changing it. All fields are bytes so that the record does not depend on
+ * structure padding, and it has to fit into the mailbox output arguments.
+ */
+#define DDR_TELEMETRY_VERSION		1
+
+#define DDR_TELEMETRY_WARM_BOOT		0x01 /* restored from warm boot */
+#define DDR_TELEMETRY_CACHED		0x02 /* restored from training cache */
+#define DDR_TELEMETRY_FAILED		0x04 /* init_ddr() failed */
+#define DDR_TELEMETRY_QS_DONE		0x08 /* qs gating ran */
+#define DDR_TELEMETRY_VREF_DONE		0x10 /* vref training ran */
+#define DDR_TELEMETRY_DLL_DONE		0x20 /* final dll tuning ran */
+
+/* vref sweeps are sampled at every DDR_TELEMETRY_VREF_STEP-th value */
+#define DDR_TELEMETRY_VREF_STEP		4
+#define DDR_TELEMETRY_VREF_SAMPLES	(0x40 / DDR_TELEMETRY_VREF_STEP)
+
+struct ddr_telemetry {
+	unsigned char version;
+	unsigned char size;
+	unsigned char ddr_type;
+	unsigned char cs_num;
+	unsigned char flags;
+	/* qs gating cycle and tap delay per CS, 0xff if it failed */
+	unsigned char qs_cycle[MAX_CS_NUM];
+	unsigned char qs_tap[MAX_CS_NUM];
+	/* byte 0 master, byte 0 neg, byte 1 master, byte 1 neg */
+	struct {
+		unsigned char left;
+		unsigned char right;
+		unsigned char medium;
+	} dll[4];
+	unsigned char vref_read;
+	unsigned char vref_read_range;
+	unsigned char vref_write;
+	unsigned char vref_write_min;
+	unsigned char vref_write_max;
+	/* smallest dll window at vref (i * STEP + STEP - 1) */
+	unsigned char vref_read_sweep[DDR_TELEMETRY_VREF_SAMPLES];
+	unsigned char vref_write_sweep[DDR_TELEMETRY_VREF_SAMPLES];
+	unsigned char reserved[6];
+};
+
+extern struct ddr_telemetry ddr_telemetry;
+
+static inline void ddr_telemetry_vref(unsigned char *sweep, unsigned int vref,
+				      int range)
+{
+	if (vref % DDR_TELEMETRY_VREF_STEP == DDR_TELEMETRY_VREF_STEP - 1)
+		sweep[vref / DDR_TELEMETRY_VREF_STEP] = range > 0 ? range : 0;
+}
+
 struct ddr_win {
 	unsigned int base;
 	unsigned int size;
@@ -0,0 +1,110 @@
+#include "dll_search.h"
+
+void dll_search_init(struct dll_search *s)
+{
+	s->state = DLL_SEARCH_COARSE;
+	s->phase = DLL_PHSEL_START;
+	s->prev = s->first = s->last = s->before = s->after = -1;
+	s->left = DLL_PHSEL_END;
+	s->right = DLL_PHSEL_START;
+	s->probes = 0;
+}
+
+/* pick next bisection probe, or finish the edge */
+static void dll_search_bisect(struct dll_search *s)
+{
+	if (s->state == DLL_SEARCH_LEFT) {
+		/* probe at lo fails, probe at hi passes */
+		if (s->lo >= 0 && s->hi - s->lo > 1) {
+			s->phase = (s->lo + s->hi) / 2;
+			return;
+		}
+
+		s->left = s->hi;
+		s->state = DLL_SEARCH_RIGHT;
+		s->lo = s->last;
+		s->hi = s->after;
+	}
+
+	/* probe at lo passes, probe at hi fails */
+	if (s->hi >= 0 && s->hi - s->lo > 1) {
+		s->phase = (s->lo + s->hi) / 2;
+		return;
+	}
+
+	s->right = s->lo;
+	s->state = DLL_SEARCH_DONE;
+}
+
+void dll_search_result(struct dll_search *s, int pass)
+{
+	int i = s->phase;
+
+	++s->probes;
+
+	switch (s->state) {
+	case DLL_SEARCH_COARSE:
+		if (pass) {
+			if (s->after >= 0)
+				goto sweep;
+			if (s->first < 0) {
+				s->first = i;
+				s->before = s->prev;
+			}
+			s->last = i;
+		} else if (s->last >= 0 && s->after < 0) {
+			s->after = i;
+		}
+
+		if (i < DLL_PHSEL_END) {
+			s->prev = i;
+			s->phase = i + DLL_PHSEL_COARSE_STEP;
+			if (s->phase > DLL_PHSEL_END)
+				s->phase = DLL_PHSEL_END;
+		} else if (s->first < 0) {
+			goto sweep;
+		} else {
+			s->state = DLL_SEARCH_LEFT;
+			s->lo = s->before;
+			s->hi = s->first;
+			dll_search_bisect(s);
+		}
+		break;
+	case DLL_SEARCH_LEFT:
+		if (pass)
+			s->hi = i;
+		else
+			s->lo = i;
+		dll_search_bisect(s);
+		break;
+	case DLL_SEARCH_RIGHT:
+		if (pass)
+			s->lo = i;
+		else
+			s->hi = i;
+		dll_search_bisect(s);
+		break;
+	case DLL_SEARCH_SWEEP:
+		if (pass) {
+			if (i < s->left)
+				s->left = i;
+			if (i > s->right)
+				s->right = i;
+		}
+		if (i < DLL_PHSEL_END)
+			s->phase = i + DLL_PHSEL_STEP;
+		else
+			s->state = DLL_SEARCH_DONE;
+		break;
+	default:
+		break;
+	}
+
+	return;
+
+sweep:
+	s->state = DLL_SEARCH_SWEEP;
+	s->phase = DLL_PHSEL_START;
+	s->left = DLL_PHSEL_END;
+	s->right = DLL_PHSEL_START;
+}
@@ -0,0 +1,42 @@
+#ifndef _DLL_SEARCH_H_
+#define _DLL_SEARCH_H_
+
+#define DLL_PHSEL_START		0x00
+#define DLL_PHSEL_END		0x3F
+#define DLL_PHSEL_STEP		0x1
+#define DLL_PHSEL_COARSE_STEP	0x8
+
+/*
+ * Search of the passing window of one byte lane. The phase to probe next is in
+ * phase, dll_search_result() is called with the outcome. Probing every
+ * DLL_PHSEL_COARSE_STEP-th phase finds the window, whose edges are then
+ * bisected between the outermost passing and the adjacent failing coarse
+ * probes. If no coarse probe passes, or a failing one lies between passing
+ * ones, all phases are probed instead.
+ *
+ * For a convex window the result is the same as found by probing all phases.
+ * Otherwise it may differ: passing phases hidden between two failing coarse
+ * probes are not seen, and a failing phase within the window is only seen if
+ * it is a coarse probe.
+ */
+enum dll_search_state {
+	DLL_SEARCH_COARSE,
+	DLL_SEARCH_LEFT,
+	DLL_SEARCH_RIGHT,
+	DLL_SEARCH_SWEEP,
+	DLL_SEARCH_DONE,
+};
+
+struct dll_search {
+	enum dll_search_state state;
+	int phase;
+	int prev, first, last, before, after;
+	int lo, hi;
+	unsigned short left, right;
+	int probes;
+};
+
+void dll_search_init(struct dll_search *s);
+void dll_search_result(struct dll_search *s, int pass);
+
+#endif /* _DLL_SEARCH_H_ */
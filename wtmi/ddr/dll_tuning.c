@@ -41,16 +41,14 @@
 
 #include "ddr.h"
 #include "ddr_support.h"
+#include "dll_search.h"
 
-#define DLL_PHSEL_START		0x00
-#define DLL_PHSEL_END		0x3F
-#define DLL_PHSEL_STEP		0x1
 #define BYTE_MASK(byte)		(0xff00ff << (byte * 8))
 #define BYTE_CONTROL(byte)	(PHY_DLL_CONTROL_BASE + (byte) * 4)
 #define DLL_MASTER		16
 #define DLL_NEG			24
 #define DLL_TYPE_MASK(type)	(0x3F << (type))
-#define BYTE_ERROR(a, b, mask)	(((a) & (mask)) != ((b) & (mask)))
+#define NUM_BYTES		2
 
 
 struct dll_tuning_info {
@@ -134,11 +132,28 @@ static const unsigned int tune_patterns[] =
 	0xffff0000
 };
 
-static int static_pattern(unsigned int wdata, unsigned int start,
+/* all byte lanes selected by byte_mask have at least one error in err */
+static int lanes_failed(u32 err, u32 byte_mask)
+{
+	int byte;
+
+	for (byte = 0; byte < NUM_BYTES; ++byte)
+		if ((byte_mask & BYTE_MASK(byte)) && !(err & BYTE_MASK(byte)))
+			return 0;
+
+	return 1;
+}
+
+/*
+ * The tests return bits in which data read back differed, limited to
+ * byte_mask. They stop as soon as every tested byte lane has failed.
+ */
+static u32 static_pattern(unsigned int wdata, unsigned int start,
 			  unsigned int end, u32 byte_mask)
 {
 	volatile unsigned int *l_waddr;
 	unsigned int l_rdata;
+	u32 err = 0;
 
 	for (l_waddr = (volatile unsigned int *)start;
 		 l_waddr < (volatile unsigned int *)end;
@@ -146,17 +161,19 @@ static int static_pattern(unsigned int wdata, unsigned int start,
 		*l_waddr = wdata;// write data in
 		l_rdata = *l_waddr;// read data back
 
-		if (BYTE_ERROR(l_rdata, wdata, byte_mask))
-			return 1;
+		err |= (l_rdata ^ wdata) & byte_mask;
+		if (err && lanes_failed(err, byte_mask))
+			break;
 	}
 
-	return 0;
+	return err;
 }
 
-static int walking1_pattern(unsigned int start, unsigned int end, u32 byte_mask)
+static u32 walking1_pattern(unsigned int start, unsigned int end, u32 byte_mask)
 {
 	volatile unsigned int *waddr;// a pointer to a short( 16 bit)
 	unsigned int wdata, rdata;
+	u32 err = 0;
 	int i;
 
 	wdata = 0x8000;//original data 16 bits
@@ -168,30 +185,32 @@ static int walking1_pattern(unsigned int start, unsigned int end, u32 byte_mask)
 			*waddr = wdata;// write data in
 			rdata = *waddr;// read data back
 
-			if (BYTE_ERROR(wdata, rdata, byte_mask))
-				return 1;
+			err |= (wdata ^ rdata) & byte_mask;
+			if (err && lanes_failed(err, byte_mask))
+				return err;
 		}
 	}
 
-	return 0;
+	return err;
 }
 
-static int ddr_wr_test(unsigned int start, unsigned int size, u32 byte_mask)
+static u32 ddr_wr_test(unsigned int start, unsigned int size, u32 byte_mask)
 {
 	unsigned int end;
+	u32 err = 0;
 	int i;
 
 	end = start + size;
 
 	for (i = 0; i < sizeof(tune_patterns) / sizeof(tune_patterns[0]); i++) {
-		if (static_pattern(tune_patterns[i], start, end, byte_mask))
-			return 1;
+		err |= static_pattern(tune_patterns[i], start, end, byte_mask);
+		if (err && lanes_failed(err, byte_mask))
+			return err;
 	}
 
-	if (walking1_pattern(start, end, byte_mask))
-		return 1;
+	err |= walking1_pattern(start, end, byte_mask);
 
-	return 0; /* pass */
+	return err;
 }
 
 void reset_dll_phy(void)
@@ -211,11 +230,12 @@ void reset_dll_phy(void)
 	wait_ns(640);                   		//delay(512nCK);Assuming 800MHz CPU frequency
 }
 
-static bool mpr_read_test(unsigned int start, unsigned int ddr_size,
-				  u32 byte_mask)
+static u32 mpr_read_test(unsigned int start, unsigned int ddr_size,
+			 u32 byte_mask)
 {
 	volatile unsigned int *l_waddr;
 	unsigned int l_rdata, l_pattern_ddr4;
+	u32 err = 0;
 
 	l_pattern_ddr4 = 0xFFFF0000;
 
@@ -224,25 +244,36 @@ static bool mpr_read_test(unsigned int start, unsigned int ddr_size,
 	     l_waddr++) {
 		l_rdata = *l_waddr;
 
-		if (BYTE_ERROR(l_rdata, l_pattern_ddr4, byte_mask))
-			return 1; /* 1 => fail */
+		err |= (l_rdata ^ l_pattern_ddr4) & byte_mask;
+		if (err && lanes_failed(err, byte_mask))
+			break;
 	}
-	return 0;
+	return err;
 }
-/* Check correctness of ddr read/write for all dll values.
- * Returns the working dll range.
+
+/* Check correctness of ddr read/write for dll values.
+ * Both byte lanes are searched at once: each is set to the phase its search
+ * wants to probe, and one DLL reset and one memory test per chip select serve
+ * both. Each lane has its own DLL and data bits, so errors are told apart by
+ * the byte mask and a failing lane does not affect the result of the other.
+ * Returns the working dll range of each byte lane.
  */
 bool short_dll_tune(unsigned int ratio,
 			    unsigned int mpr_en,
 			    const struct ddr_init_para *params,
 			    unsigned int num_of_cs,
-			    struct dll_tuning_info *ret, u32 dll_type,
-			    u32 mask, u32 ctrl_addrs)
+			    struct dll_tuning_info *ret, u32 dll_type)
 {
-	unsigned short left, right, i;
+	struct dll_search search[NUM_BYTES];
 	unsigned short medium;
-	unsigned int regval, res;
-	u32 beckup = ll_read32(ctrl_addrs);
+	unsigned int regval;
+	u32 beckup[NUM_BYTES], mask, err;
+	int byte, cs, resets = 0, active;
+
+	for (byte = 0; byte < NUM_BYTES; ++byte) {
+		beckup[byte] = ll_read32(BYTE_CONTROL(byte));
+		dll_search_init(&search[byte]);
+	}
 
 	ll_write32(PHY_CONTROL_9, 0x0);
 
@@ -262,53 +293,80 @@ bool short_dll_tune(unsigned int ratio,
 
 	LogMsg(LOG_LEVEL_DEBUG,
 	       FLAG_REGS_DLL_TUNE,
-	       "Increment dll_phsel by 1 and find the passing window");
+	       "Probe dll_phsel coarsely and find the passing window");
 	/* enable mpr mode */
 	if(mpr_en)
 	{
 		ll_write32(CH0_DRAM_Config_3, (ll_read32(CH0_DRAM_Config_3) | 0x00000040));
 		ll_write32(USER_COMMAND_2, 0x13000800);
 	}
-	left = DLL_PHSEL_END;
-	right = DLL_PHSEL_START;
-
-	for (i = DLL_PHSEL_START; i <= DLL_PHSEL_END; ++i) {
-		int cs;
 
-		replace_val(ctrl_addrs, i,
-			     dll_type, DLL_TYPE_MASK(dll_type));
+	do {
+		mask = 0;
+		for (byte = 0; byte < NUM_BYTES; ++byte) {
+			if (search[byte].state == DLL_SEARCH_DONE)
+				continue;
+			replace_val(BYTE_CONTROL(byte), search[byte].phase,
+				     dll_type, DLL_TYPE_MASK(dll_type));
+			mask |= BYTE_MASK(byte);
+		}
 		reset_dll_phy();
 		wait_ns(100);
+		++resets;
 
-		res = 0;
+		err = 0;
 		for (cs = 0; cs < num_of_cs; ++cs) {
 			if (mpr_en)
-				res |= mpr_read_test(params->cs_wins[cs].base,
+				err |= mpr_read_test(params->cs_wins[cs].base,
 						     100*2, mask);
 			else
-				res |= ddr_wr_test(params->cs_wins[cs].base,
+				err |= ddr_wr_test(params->cs_wins[cs].base,
 						   32, mask);
 		}
-		if (!res) { /* pass */
-			if( i<left) left = i;
-			if( i>right) right = i;
-			LogMsg(LOG_LEVEL_DEBUG, FLAG_REGS_DLL_TUNE, "\n\t\tdll_phsel_0 = dll_phsel_1 = 0x%02X left = 0x%02X, right = 0x%02X", i, left, right);
+
+		active = 0;
+		for (byte = 0; byte < NUM_BYTES; ++byte) {
+			if (search[byte].state == DLL_SEARCH_DONE)
+				continue;
+			LogMsg(LOG_LEVEL_DEBUG, FLAG_REGS_DLL_TUNE,
+			       "\n\t\tbyte %d dll_phsel = 0x%02X %s", byte,
+			       search[byte].phase,
+			       err & BYTE_MASK(byte) ? "fail" : "pass");
+			dll_search_result(&search[byte],
+					  !(err & BYTE_MASK(byte)));
+			if (search[byte].state == DLL_SEARCH_SWEEP &&
+			    search[byte].phase == DLL_PHSEL_START)
+				LogMsg(LOG_LEVEL_DEBUG, FLAG_REGS_DLL_TUNE,
+				       "\n\t\tWindow not convex, probing all phases");
+			active |= search[byte].state != DLL_SEARCH_DONE;
 		}
-	}
-	ll_write32(ctrl_addrs, beckup);
+	} while (active);
+
+	for (byte = 0; byte < NUM_BYTES; ++byte)
+		ll_write32(BYTE_CONTROL(byte), beckup[byte]);
 	reset_dll_phy();
-	if (left > right) {
+
+	LogMsg(LOG_LEVEL_DEBUG, FLAG_REGS_DLL_TUNE,
+	       "\n\t\t%d DLL resets for %d + %d probes", resets,
+	       search[0].probes, search[1].probes);
+
+	for (byte = 0; byte < NUM_BYTES; ++byte) {
+		unsigned short left = search[byte].left;
+		unsigned short right = search[byte].right;
+
+		if (left > right) {
+			LogMsg(LOG_LEVEL_DEBUG, FLAG_REGS_DLL_TUNE,
+			       "\n\t\tNo passing window");
+			return 0;
+		}
+		medium = left + ((right-left)/ratio);
 		LogMsg(LOG_LEVEL_DEBUG, FLAG_REGS_DLL_TUNE,
-		       "\n\t\tNo passing window");
-		return 0;
+		       "\n\t\tByte %d passing window: 0x%02X-0x%02X \t\tMedium = 0x%02X",
+		       byte, left, right, medium);
+		ret[byte].left = left;
+		ret[byte].right = right;
+		ret[byte].medium = medium;
 	}
-	medium = left + ((right-left)/ratio);
-	LogMsg(LOG_LEVEL_DEBUG, FLAG_REGS_DLL_TUNE,
-	       "\n\t\tPassing window: 0x%02X-0x%02X \t\tMedium = 0x%02X",
-	       left, right, medium);
-	ret->left = left;
-	ret->right = right;
-	ret->medium = medium;
 	/* disable mpr mode */
 	if (mpr_en)
 	{
@@ -325,37 +383,45 @@ int dll_tuning(unsigned int ratio, unsigned int num_of_cs,
 	       const struct ddr_init_para *init_para, bool mpr_mode,
 	       bool save_res)
 {
-	unsigned int i;
+	unsigned int i, byte;
 	/* size start at max dll range */
 	int size = DLL_PHSEL_END - DLL_PHSEL_START;
-	unsigned short byte[] = {0, 0, 1, 1};
-	u32 dll_type[] = {DLL_MASTER, DLL_NEG, DLL_MASTER, DLL_NEG};
+	u32 dll_type[] = {DLL_MASTER, DLL_NEG};
 	const int loop_size = (sizeof(dll_type) / sizeof(dll_type[0]));
-	u32 med[loop_size];
-	struct dll_tuning_info dll_info;
+	u32 med[loop_size][NUM_BYTES];
+	struct dll_tuning_info dll_info[NUM_BYTES];
 
 	LogMsg(LOG_LEVEL_DEBUG, FLAG_REGS_DLL_TUNE,
 	       "\nPerform coarse DLL tuning:");
 
 	for (i = 0; i < loop_size; ++i) {
-		int current_size;
-
 		if (!short_dll_tune(ratio, mpr_mode, init_para, num_of_cs,
-				    &dll_info, dll_type[i], BYTE_MASK(byte[i]),
-				     BYTE_CONTROL(byte[i])))
+				    dll_info, dll_type[i]))
 			return 0;
-		current_size = dll_info.right - dll_info.left;
-		/* select minimum size of each byte0/1
-		 * and dll master/neg variation
-		 */
-		med[i] = dll_info.medium;
-		if (current_size < size)
-			size = current_size;
+
+		for (byte = 0; byte < NUM_BYTES; ++byte) {
+			int current_size = dll_info[byte].right -
+					   dll_info[byte].left;
+
+			/* select minimum size of each byte0/1
+			 * and dll master/neg variation
+			 */
+			med[i][byte] = dll_info[byte].medium;
+			if (save_res) {
+				/* telemetry order is byte 0 master, neg, byte 1 master, neg */
+				ddr_telemetry.dll[byte * loop_size + i].left = dll_info[byte].left;
+				ddr_telemetry.dll[byte * loop_size + i].right = dll_info[byte].right;
+				ddr_telemetry.dll[byte * loop_size + i].medium = dll_info[byte].medium;
+			}
+			if (current_size < size)
+				size = current_size;
+		}
 	}
 	if (save_res) {
 		for (i = 0; i < loop_size; ++i)
-			replace_val(BYTE_CONTROL(byte[i]), med[i],
-			dll_type[i], DLL_TYPE_MASK(dll_type[i]));
+			for (byte = 0; byte < NUM_BYTES; ++byte)
+				replace_val(BYTE_CONTROL(byte), med[i][byte],
+				dll_type[i], DLL_TYPE_MASK(dll_type[i]));
 		reset_dll_phy();
 		wait_ns(100);
 	}
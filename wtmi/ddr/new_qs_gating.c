@@ -101,6 +101,8 @@ int qs_gating(unsigned int base_addr, unsigned int cs_num, struct ddr_init_resul
                         //7.If QSG_Dx_OUTP == 0xF and QSG_Dx_OUTN == 0xE, then calibration is done
                         if( (result_outp == 0xFF) && (result_outn == 0xEE) ) {
 				LogMsg(LOG_LEVEL_INFO, FLAG_REGS_QS_GATE, "\n\tCS%d: Final Cycle = 0x%02X Tap = 0x%02X", cs_num, rl_cycle_dly, rl_tap_dly);
+				ddr_telemetry.qs_cycle[cs_num] = rl_cycle_dly;
+				ddr_telemetry.qs_tap[cs_num] = rl_tap_dly;
                                 cal_done_flag = 1;
                                 break;
                         }
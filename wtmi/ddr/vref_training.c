@@ -53,12 +53,18 @@ int vref_read_training(int num_of_cs, struct ddr_init_para init_para)
 		       "\nSet VREF: 0x%02X", vref_cnt);
 		vdac_set(1, vref_cnt);
 		dll_range = dll_tuning(2, num_of_cs, &init_para, false, false);
+		ddr_telemetry_vref(ddr_telemetry.vref_read_sweep, vref_cnt,
+				   dll_range);
 		if (dll_range > best_range) {
 			best_range = dll_range;
 			best_vref_cnt = vref_cnt;
 		}
 
 	}
+	if (best_vref_cnt >= 0) {
+		ddr_telemetry.vref_read = best_vref_cnt;
+		ddr_telemetry.vref_read_range = best_range;
+	}
 	return best_vref_cnt;
 }
 
@@ -106,6 +112,8 @@ unsigned int vref_write_training(int num_of_cs, struct ddr_init_para init_para)
                 LogMsg(LOG_LEVEL_DEBUG, FLAG_REGS_VREF_WRITE, "\nSet VREF: 0x%02X", vref_cnt);
                 vref_set(1, vref_cnt);
 		result_dll = dll_tuning(2, num_of_cs, &init_para, false, false);
+		ddr_telemetry_vref(ddr_telemetry.vref_write_sweep, vref_cnt,
+				   (int)result_dll);
 
 		if (result_dll > 0) /* if DLL pass */
                 {
@@ -147,8 +155,11 @@ unsigned int vref_write_training(int num_of_cs, struct ddr_init_para init_para)
 	//disable vref training
         en_dis_write_vref(0);
 
-        if(prev_min!=prev_max)                                                  //prev values are the correct ones
+        ddr_telemetry.vref_write_min = prev_min;
+        ddr_telemetry.vref_write_max = prev_max;
+        if(prev_min!=prev_max) {                                                //prev values are the correct ones
+                ddr_telemetry.vref_write = ((prev_max-prev_min)/2) + prev_min;
                 return (((prev_max-prev_min)/2) + prev_min);			//PASS
-        else
+        } else
                 return 0;							//FAIL
 }
@@ -0,0 +1,173 @@
+#include "types.h"
+#include "io.h"
+#include "board.h"
+#include "crc32.h"
+#include "ddr_cache.h"
+#include "errno.h"
+#include "spi.h"
+#include "string.h"
+#include "stdio.h"
+#include "debug.h"
+
+/*
+ * DDR training results are stored in one 4 KiB sector of SPI NOR at offset
+ * DDR_TRAINING_CACHE. The record is protected by CRC32 and only used if its
+ * key matches the current board and DDR configuration. Even then the restored
+ * settings have to pass a memory test, otherwise full training is done and
+ * the record is rewritten. Telemetry of the training is kept with the results
+ * so that it is still available when booting from the cache.
+ */
+#if DDR_TRAINING_CACHE % 4096
+#error "DDR_TRAINING_CACHE has to be 4 KiB aligned, it is erased by sectors"
+#endif
+
+#define DDR_CACHE_NOR_OFFSET	(DDR_TRAINING_CACHE)
+#define DDR_CACHE_MAGIC		0x43524444 /* "DDRC" */
+
+/* bytes per chip select checked by ddr_cache_test() */
+#define DDR_CACHE_TEST_SIZE	1024
+
+struct ddr_cache {
+	u32 magic;
+	u32 size;
+	struct ddr_cache_key key;
+	struct ddr_init_result result;
+	struct ddr_telemetry telemetry;
+	u32 crc;
+};
+
+static u32 ddr_cache_crc(const struct ddr_cache *rec)
+{
+	return crc32(0, rec, sizeof(*rec) - sizeof(rec->crc));
+}
+
+int ddr_cache_load(const struct ddr_cache_key *key,
+		   struct ddr_init_result *result,
+		   struct ddr_telemetry *telemetry)
+{
+	struct ddr_cache rec;
+
+	spi_init(&nordev);
+	spi_nor_read(&nordev, &rec, DDR_CACHE_NOR_OFFSET, sizeof(rec));
+
+	if (rec.magic != DDR_CACHE_MAGIC || rec.size != sizeof(rec))
+		return -ENODATA;
+
+	if (rec.crc != ddr_cache_crc(&rec))
+		return -EIO;
+
+	if (memcmp(&rec.key, key, sizeof(*key)))
+		return -ENODATA;
+
+	memcpy(result, &rec.result, sizeof(*result));
+	memcpy(telemetry, &rec.telemetry, sizeof(*telemetry));
+
+	return 0;
+}
+
+int ddr_cache_store(const struct ddr_cache_key *key,
+		    const struct ddr_init_result *result,
+		    const struct ddr_telemetry *telemetry)
+{
+	struct ddr_cache rec, check;
+	int ret;
+
+	memset(&rec, 0, sizeof(rec));
+	rec.magic = DDR_CACHE_MAGIC;
+	rec.size = sizeof(rec);
+	memcpy(&rec.key, key, sizeof(*key));
+	memcpy(&rec.result, result, sizeof(*result));
+	memcpy(&rec.telemetry, telemetry, sizeof(*telemetry));
+	rec.crc = ddr_cache_crc(&rec);
+
+	spi_init(&nordev);
+
+	ret = spi_nor_erase_4k(&nordev, DDR_CACHE_NOR_OFFSET);
+	if (ret < 0)
+		return ret;
+
+	ret = spi_nor_write(&nordev, &rec, DDR_CACHE_NOR_OFFSET, sizeof(rec));
+	if (ret < 0)
+		return ret;
+
+	spi_nor_read(&nordev, &check, DDR_CACHE_NOR_OFFSET, sizeof(check));
+	if (memcmp(&rec, &check, sizeof(rec)))
+		return -EIO;
+
+	return 0;
+}
+
+static u32 ddr_cache_pattern(int pass, volatile u32 *base, u32 i)
+{
+	switch (pass) {
+	case 0:
+		return (u32)&base[i];
+	case 1:
+		return ~(u32)&base[i];
+	default:
+		/* walking one, inverted every other 32 words */
+		return BIT(i % 32) ^ -((i / 32) & 1);
+	}
+}
+
+/*
+ * Quick test of restored settings: address, inverted address and walking ones
+ * patterns over the first DDR_CACHE_TEST_SIZE bytes of each chip select. Like
+ * the sanity test after training, it stays away from the preloaded boot image.
+ */
+int ddr_cache_test(const struct ddr_init_para *para, int cs_num)
+{
+	int cs, pass;
+	u32 i;
+
+	for (cs = 0; cs < cs_num; ++cs) {
+		volatile u32 *base = (volatile u32 *)para->cs_wins[cs].base;
+
+		for (pass = 0; pass < 3; ++pass) {
+			for (i = 0; i < DDR_CACHE_TEST_SIZE / 4; ++i)
+				base[i] = ddr_cache_pattern(pass, base, i);
+
+			for (i = 0; i < DDR_CACHE_TEST_SIZE / 4; ++i)
+				if (base[i] != ddr_cache_pattern(pass, base, i))
+					return -EIO;
+		}
+	}
+
+	return 0;
+}
+
+DECL_DEBUG_CMD(cmd_ddrcache)
+{
+	struct ddr_cache rec;
+
+	spi_init(&nordev);
+
+	if (argc > 1 && !strcmp(argv[1], "erase")) {
+		if (spi_nor_erase_4k(&nordev, DDR_CACHE_NOR_OFFSET) < 0)
+			printf("Erase failed\n");
+		return;
+	} else if (argc > 1) {
+		printf("usage: ddrcache [erase]\n");
+		return;
+	}
+
+	spi_nor_read(&nordev, &rec, DDR_CACHE_NOR_OFFSET, sizeof(rec));
+	if (rec.magic != DDR_CACHE_MAGIC || rec.size != sizeof(rec)) {
+		printf("No DDR training cache at 0x%x\n", DDR_CACHE_NOR_OFFSET);
+		return;
+	}
+
+	printf("DDR training cache at 0x%x%s\n", DDR_CACHE_NOR_OFFSET,
+	       rec.crc != ddr_cache_crc(&rec) ? " (bad CRC)" : "");
+	printf("board %u, DDR%u, %u MiB, %u CS, speed bin %u, clock %u\n",
+	       rec.key.board, rec.key.ddr_type == DDR4 ? 4 : 3,
+	       rec.key.ram_size, rec.key.cs_num, rec.key.speed_bin,
+	       rec.key.clock);
+	printf("dll b0 %08x b1 %08x adcm %08x\n",
+	       rec.result.dll_tune.dll_ctrl_b0,
+	       rec.result.dll_tune.dll_ctrl_b1,
+	       rec.result.dll_tune.dll_ctrl_adcm);
+}
+
+DEBUG_CMD("ddrcache", "Show or erase cached DDR training results",
+	  cmd_ddrcache);
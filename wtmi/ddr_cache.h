@@ -0,0 +1,54 @@
+#ifndef _DDR_CACHE_H_
+#define _DDR_CACHE_H_
+
+#include "types.h"
+#include "errno.h"
+#include "ddr/ddrcore.h"
+
+/*
+ * Cached DDR training results are only used if all of these match the
+ * current boot.
+ */
+struct ddr_cache_key {
+	u32 board;
+	u32 ddr_type;
+	u32 ram_size;
+	u32 cs_num;
+	u32 speed_bin;
+	u32 clock;
+};
+
+#ifdef DDR_TRAINING_CACHE
+
+extern int ddr_cache_load(const struct ddr_cache_key *key,
+			  struct ddr_init_result *result,
+			  struct ddr_telemetry *telemetry);
+extern int ddr_cache_store(const struct ddr_cache_key *key,
+			   const struct ddr_init_result *result,
+			   const struct ddr_telemetry *telemetry);
+extern int ddr_cache_test(const struct ddr_init_para *para, int cs_num);
+
+#else /* !DDR_TRAINING_CACHE */
+
+static inline int ddr_cache_load(const struct ddr_cache_key *key,
+				 struct ddr_init_result *result,
+				 struct ddr_telemetry *telemetry)
+{
+	return -EOPNOTSUPP;
+}
+
+static inline int ddr_cache_store(const struct ddr_cache_key *key,
+				  const struct ddr_init_result *result,
+				  const struct ddr_telemetry *telemetry)
+{
+	return -EOPNOTSUPP;
+}
+
+static inline int ddr_cache_test(const struct ddr_init_para *para, int cs_num)
+{
+	return -EOPNOTSUPP;
+}
+
+#endif /* !DDR_TRAINING_CACHE */
+
+#endif /* _DDR_CACHE_H_ */
@@ -7,6 +7,7 @@
 #include "crypto_hash.h"
 #include "string.h"
 #include "engine.h"
+#include "div64.h"
 #include "debug.h"
 
 #define EBG_CTRL	0x40002c00
@@ -33,6 +34,29 @@ static cbuf_t paranoid_rand_cbuf = {
 
 static u32 reg;
 
+/*
+ * The EBG has no documented interrupt, so the pool is refilled from the systick
+ * handler. In each tick at most EBG_TICK_BUDGET_US microseconds are spent
+ * harvesting, and the handler returns as soon as the EBG has no new sample
+ * ready. Code running in the main context sets ebg_busy while it touches
+ * the EBG or ebg_cbuf, and the handler skips such ticks.
+ */
+#define EBG_TICK_BUDGET_US	250
+
+static volatile int ebg_busy;
+static int ebg_enabled;
+
+static struct {
+	u32 harvested;
+	u32 harvest_us;
+	u32 refill_start;
+	u32 refill_from;
+	int refilling;
+	u32 last_refill_us;
+	u32 last_refill_from;
+	u32 max_refill_us;
+} ebg_stats;
+
 static int ebg_next(int wait, u16 *res)
 {
 	u32 val;
@@ -93,6 +117,8 @@ void ebg_init(void)
 	x &= 0x1f;
 	for (i = 0; i < x; ++i)
 		ebg_next(1, NULL);
+
+	ebg_enabled = 1;
 }
 
 static u32 cbuf_pull(cbuf_t *cbuf, void *dest, u32 len)
@@ -152,19 +178,56 @@ static u32 cbuf_push(cbuf_t *cbuf, const void *src, u32 len)
 
 static const void *paranoid_rand_64(void);
 
-void ebg_process(void) {
-	u16 val;
+/* called with ebg_busy set, after something was pulled from ebg_cbuf */
+static void ebg_drained(void)
+{
+	if (ebg_stats.refilling || !cbuf_free_space(&ebg_cbuf))
+		return;
 
-	if (ebg_cbuf.len >= 512 && cbuf_free_space(&paranoid_rand_cbuf) >= 64)
-		cbuf_push(&paranoid_rand_cbuf, paranoid_rand_64(), 64);
+	ebg_stats.refilling = 1;
+	ebg_stats.refill_start = get_timer_us();
+	ebg_stats.refill_from = ebg_cbuf.len;
+}
 
-	if (ebg_cbuf.len > ebg_cbuf.size - 2)
-		return;
+static void ebg_refilled(u32 now)
+{
+	u32 us = now - ebg_stats.refill_start;
+
+	ebg_stats.refilling = 0;
+	ebg_stats.last_refill_us = us;
+	ebg_stats.last_refill_from = ebg_stats.refill_from;
+	if (us > ebg_stats.max_refill_us)
+		ebg_stats.max_refill_us = us;
+}
 
-	if (ebg_next(0, &val) < 0)
+void ebg_systick(void)
+{
+	u32 start, now;
+	u16 val;
+
+	if (!ebg_enabled || ebg_busy || !cbuf_free_space(&ebg_cbuf))
 		return;
 
-	cbuf_push(&ebg_cbuf, &val, 2);
+	now = start = get_timer_us();
+	while (ebg_cbuf.len <= ebg_cbuf.size - 2 &&
+	       now - start < EBG_TICK_BUDGET_US) {
+		if (ebg_next(0, &val))
+			break;
+		cbuf_push(&ebg_cbuf, &val, 2);
+		ebg_stats.harvested += 2;
+		now = get_timer_us();
+	}
+
+	ebg_stats.harvest_us += now - start;
+
+	if (ebg_stats.refilling && ebg_cbuf.len > ebg_cbuf.size - 2)
+		ebg_refilled(now);
+}
+
+void ebg_process(void) {
+	if (ebg_cbuf.len >= 512 && cbuf_free_space(&paranoid_rand_cbuf) >= 64 &&
+	    !hw_hash_busy())
+		cbuf_push(&paranoid_rand_cbuf, paranoid_rand_64(), 64);
 }
 
 void ebg_rand_sync(void *buffer, u32 size)
@@ -172,7 +235,10 @@ void ebg_rand_sync(void *buffer, u32 size)
 	u32 pull;
 	u16 val;
 
+	ebg_busy = 1;
+
 	pull = cbuf_pull(&ebg_cbuf, buffer, size);
+	ebg_drained();
 	buffer += pull;
 	size -= pull;
 
@@ -194,11 +260,20 @@ void ebg_rand_sync(void *buffer, u32 size)
 		ebg_next(1, &val);
 		*(u8 *)buffer = val & 0xff;
 	}
+
+	ebg_busy = 0;
 }
 
 u32 ebg_rand(void *buffer, u32 size)
 {
-	return cbuf_pull(&ebg_cbuf, buffer, MIN(ebg_cbuf.len, size));
+	u32 res;
+
+	ebg_busy = 1;
+	res = cbuf_pull(&ebg_cbuf, buffer, MIN(ebg_cbuf.len, size));
+	ebg_drained();
+	ebg_busy = 0;
+
+	return res;
 }
 
 static inline void xor(u32 *d, const u32 *s)
@@ -209,37 +284,82 @@ static inline void xor(u32 *d, const u32 *s)
 		*d++ ^= *s++;
 }
 
+static void paranoid_rand_combine(u32 *dgst, const u32 *ebg)
+{
+	static int c;
+	int i;
+
+	for (i = 0; i < 128; i += 16) {
+		if (c)
+			xor(dgst, ebg + i);
+		else
+			c ^= bn_add(dgst, ebg + i, 16);
+		c ^= (dgst[0] >> (i >> 4)) & 1;
+	}
+}
+
 /*
- * This function collects 512 bytes from the Entropy Bit Generator, appends to
- * it the digest computed in the previous call to this function (if there was no
- * previous call it appends zeros), and hashes the resultin 576 bytes with
- * sha512. The resulting digest will be used in the next call, and is also
- * combined with the output of EBG to generate the result.
- *              call 0             call 1           call 2
+ * This function generates n blocks of 64 random bytes. For each block it
+ * collects 512 bytes from the Entropy Bit Generator, appends to it the digest
+ * computed for the previous block (if there was no previous block it appends
+ * zeros), and hashes the resulting 576 bytes with sha512. The resulting digest
+ * will be used for the next block, and is also combined with the output of EBG
+ * to generate the result.
+ *              block 0            block 1          block 2
  * prev digest  0000               H0               H1
  * EBG output   EBG0               EBG1             EBG2             ...
  * cur digest   H0 = H(EBG0|0000)  H1 = H(EBG1|H0)  H2 = H(EBG2|H1)
  * result       C(EBG0,H0)         C(EBG1,H1)       C(EBG2|H2)
+ *
+ * The EBG output for the next block is collected into a second buffer while
+ * the hash engine is working on the current block.
+ *
+ * If dest is NULL (only allowed for n = 1), the result is left in
+ * paranoid_rand_dgst.
  */
-static const void *paranoid_rand_64(void)
+static void paranoid_rand_gen(void *dest, u32 n)
 {
 	extern u32 ebgbuf[128 + 16] asm("paranoid_rand_tmp");
 	extern u32 dgst[16] asm("paranoid_rand_dgst");
-	static int c;
-	int i;
+	static u32 ebgbuf2[128 + 16] __attribute__((aligned(16)));
+	u32 *cur = ebgbuf, *next = ebgbuf2, *tmp;
 
-	ebg_rand_sync(ebgbuf, sizeof(ebgbuf) - sizeof(dgst));
-	hw_sha512(ebgbuf, sizeof(ebgbuf), dgst);
-	memcpy(&ebgbuf[128], dgst, sizeof(dgst));
+	ebg_rand_sync(cur, 512);
+	hw_hash_start(HASH_SHA512, cur, sizeof(ebgbuf));
 
-	for (i = 0; i < 128; i += 16) {
-		if (c)
-			xor(dgst, ebgbuf + i);
-		else
-			c ^= bn_add(dgst, ebgbuf + i, 16);
-		c ^= (dgst[0] >> (i >> 4)) & 1;
+	while (n--) {
+		if (n)
+			ebg_rand_sync(next, 512);
+
+		hw_hash_finish(dgst);
+		memcpy(&next[128], dgst, sizeof(dgst));
+
+		if (n)
+			hw_hash_start(HASH_SHA512, next, sizeof(ebgbuf));
+
+		paranoid_rand_combine(dgst, cur);
+		if (dest) {
+			memcpy(dest, dgst, sizeof(dgst));
+			dest += sizeof(dgst);
+		}
+
+		tmp = cur;
+		cur = next;
+		next = tmp;
 	}
 
+	/* the digest for the next call must be in paranoid_rand_tmp */
+	if (cur != ebgbuf)
+		memcpy(&ebgbuf[128], &cur[128], sizeof(dgst));
+	bzero(ebgbuf2, sizeof(ebgbuf2));
+}
+
+static const void *paranoid_rand_64(void)
+{
+	extern u32 dgst[16] asm("paranoid_rand_dgst");
+
+	paranoid_rand_gen(NULL, 1);
+
 	return dgst;
 }
 
@@ -251,10 +371,10 @@ void paranoid_rand(void *buffer, u32 size)
 	buffer += pull;
 	size -= pull;
 
-	while (size >= 64) {
-		memcpy(buffer, paranoid_rand_64(), 64);
-		buffer += 64;
-		size -= 64;
+	if (size >= 64) {
+		paranoid_rand_gen(buffer, size / 64);
+		buffer += size & ~63;
+		size &= 63;
 	}
 
 	if (size) {
@@ -264,6 +384,53 @@ void paranoid_rand(void *buffer, u32 size)
 	}
 }
 
+static void ebg_print_stats(void)
+{
+	u64 rate;
+
+	rate = (u64)ebg_stats.harvested * 1000000;
+	do_div(rate, MAX(ebg_stats.harvest_us, 1U));
+	printf("EBG harvested: %u bytes in %u us, %llu bytes/s\n",
+	       ebg_stats.harvested, ebg_stats.harvest_us, rate);
+
+	if (ebg_stats.last_refill_us) {
+		rate = (u64)(ebg_cbuf.size - ebg_stats.last_refill_from) *
+		       1000000;
+		do_div(rate, ebg_stats.last_refill_us);
+		printf("EBG last refill: from %u bytes in %u us (%llu bytes/s), max %u us\n",
+		       ebg_stats.last_refill_from, ebg_stats.last_refill_us,
+		       rate, ebg_stats.max_refill_us);
+	}
+
+	if (ebg_stats.refilling)
+		printf("EBG refilling for %u us\n",
+		       get_timer_us() - ebg_stats.refill_start);
+}
+
+static void rand_bench(int strong, u32 len)
+{
+	static u8 buf[1024];
+	u32 start, us, done, n;
+	u64 rate;
+
+	start = get_timer_us();
+	for (done = 0; done < len; done += n) {
+		n = MIN(len - done, sizeof(buf));
+		if (strong)
+			paranoid_rand(buf, n);
+		else
+			ebg_rand_sync(buf, n);
+	}
+	us = get_timer_us() - start;
+	bzero(buf, sizeof(buf));
+
+	rate = (u64)len * 1000000;
+	do_div(rate, MAX(us, 1U));
+
+	printf("%s: %u bytes in %u us, %llu bytes/s\n", strong ? "strong" : "raw",
+	       len, us, rate);
+}
+
 DECL_DEBUG_CMD(cmd_rand)
 {
 	u32 len = 0, i, val;
@@ -287,12 +454,18 @@ DECL_DEBUG_CMD(cmd_rand)
 			paranoid_rand(&val, sizeof(val));
 			printf("%08x\n", val);
 		}
+	} else if (!strcmp(argv[1], "bench")) {
+		if (argc < 3)
+			len = 0x10000;
+		rand_bench(0, len);
+		rand_bench(1, len);
 	} else if (!strcmp(argv[1], "state")) {
 		printf("EBG buffer: %u/%u filled, start at %u\n", ebg_cbuf.len,
 		       ebg_cbuf.size, ebg_cbuf.pos);
 		printf("Paranoid rand buffer: %u/%u filled, start at %u\n",
 		       paranoid_rand_cbuf.len, paranoid_rand_cbuf.size,
 		       paranoid_rand_cbuf.pos);
+		ebg_print_stats();
 	} else {
 		goto usage;
 	}
@@ -301,6 +474,7 @@ DECL_DEBUG_CMD(cmd_rand)
 usage:
 	printf("usage: rand raw [n]\n");
 	printf("       rand strong [n]\n");
+	printf("       rand bench [bytes]\n");
 	printf("       rand state\n");
 }
 
@@ -5,6 +5,7 @@
 
 extern void ebg_init(void);
 extern void ebg_process(void);
+extern void ebg_systick(void);
 extern u32 ebg_rand(void *buffer, u32 size);
 extern void ebg_rand_sync(void *buffer, u32 size);
 extern void paranoid_rand(void *buffer, u32 size);
@@ -192,11 +192,89 @@ static int _efuse_read_row(int row, u64 *val, int *lock, int check_ecc, int sb)
 	return 0;
 }
 
+/*
+ * Shadow of the eFuse rows in SRAM. Reading a row from the controller takes
+ * microseconds of busy waiting, twice as long with ECC check, and rows only
+ * change when we program them, so each row is read once and later reads are
+ * served from the shadow. Programming a row drops it, and the rows whose ECC
+ * it holds, from the shadow. Row masking is still checked on every read.
+ */
+#define SHADOW_RAW	BIT(0)	/* shadow_val valid */
+#define SHADOW_ECC	BIT(1)	/* shadow_ecc_val valid */
+#define SHADOW_LOCK	BIT(2)	/* row locked, valid if any of the above */
+#define SHADOW_ECC_ERR	BIT(3)	/* uncorrectable ECC error, with SHADOW_ECC */
+
+static u64 shadow_val[44];
+static u64 shadow_ecc_val[44];
+static u8 shadow_flags[44];
+
+static int efuse_shadow_read(int row, u64 *val, int *lock, int check_ecc)
+{
+	u8 need, flags;
+	int res, _lock;
+	u64 _val;
+
+	if (row < 0 || row > 43)
+		return -EINVAL;
+
+	need = (check_ecc && ecc[row].row != -1) ? SHADOW_ECC : SHADOW_RAW;
+	flags = shadow_flags[row];
+
+	if (!(flags & need)) {
+		res = _efuse_read_row(row, &_val, &_lock, need == SHADOW_ECC,
+				      0);
+		if (res < 0 && res != -EIO)
+			return res;
+
+		flags &= ~SHADOW_LOCK;
+		flags |= need | (_lock ? SHADOW_LOCK : 0);
+		if (need == SHADOW_ECC) {
+			shadow_ecc_val[row] = _val;
+			flags &= ~SHADOW_ECC_ERR;
+			if (res == -EIO)
+				flags |= SHADOW_ECC_ERR;
+		} else {
+			shadow_val[row] = _val;
+		}
+		shadow_flags[row] = flags;
+	}
+
+	if (val)
+		*val = need == SHADOW_ECC ? shadow_ecc_val[row] :
+					    shadow_val[row];
+	if (lock)
+		*lock = !!(flags & SHADOW_LOCK);
+
+	return (need == SHADOW_ECC && (flags & SHADOW_ECC_ERR)) ? -EIO : 0;
+}
+
+/* drop row, and rows whose ECC it holds, from the shadow */
+static void efuse_shadow_invalidate(int row)
+{
+	int i;
+
+	shadow_flags[row] = 0;
+	for (i = 0; i < 44; ++i)
+		if (ecc[i].row == row)
+			shadow_flags[i] = 0;
+}
+
+/* read all rows into the shadow, rows failing to read are retried later */
+void efuse_shadow_fill(void)
+{
+	int row;
+
+	for (row = 0; row < 44; ++row) {
+		efuse_shadow_read(row, NULL, NULL, 0);
+		efuse_shadow_read(row, NULL, NULL, 1);
+	}
+}
+
 int efuse_read_row(int row, u64 *val, int *lock)
 {
 	int res;
 
-	res = _efuse_read_row(row, val, lock, 1, 0);
+	res = efuse_shadow_read(row, val, lock, 1);
 	if (is_row_masked(row))
 		return -EACCES;
 
@@ -207,7 +285,7 @@ int efuse_read_row_no_ecc(int row, u64 *val, int *lock)
 {
 	int res;
 
-	res = _efuse_read_row(row, val, lock, 0, 0);
+	res = efuse_shadow_read(row, val, lock, 0);
 	if (is_row_masked(row))
 		return -EACCES;
 
@@ -280,6 +358,8 @@ static int efuse_raw_write(int row, u64 val)
 	int res, i;
 	u64 _val;
 
+	efuse_shadow_invalidate(row);
+
 	res = efuse_write_enable();
 	if (res < 0)
 		return res;
@@ -317,6 +397,8 @@ static int efuse_raw_lock(int row)
 {
 	int res;
 
+	efuse_shadow_invalidate(row);
+
 	res = efuse_write_enable();
 	if (res < 0)
 		return res;
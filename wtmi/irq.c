@@ -1,6 +1,7 @@
 #include "types.h"
 #include "clock.h"
 #include "irq.h"
+#include "ebg.h"
 
 #define SYSTICK_CTRL	0xe000e010
 #define SYSTICK_RELOAD	0xe000e014
@@ -30,6 +31,7 @@ void __irq systick_handler(void)
 {
 	save_ctx();
 	++jiffies;
+	ebg_systick();
 	load_ctx();
 }
 
@@ -9,10 +9,14 @@
 #include "crypto.h"
 #include "crypto_hash.h"
 #include "ddr.h"
+#include "avs.h"
 #include "deploy.h"
 #include "soc.h"
 #include "board.h"
 #include "debug.h"
+#include "stats.h"
+#include "boottime.h"
+#include "memtest.h"
 
 static int process_ap_mem(void *param, u32 addr, u32 len,
 			  void (*cb)(void **, void *, u32))
@@ -95,17 +99,43 @@ static int check_ap_addr(u32 addr, u32 len, u32 align)
 		return 1;
 }
 
-maybe_unused static u32 cmd_get_random(u32 *args, u32 *out_args)
+/* how many bytes are processed in one slice of a long running command */
+#define RANDOM_JOB_SLICE	4096
+#define HASH_JOB_SLICE		0x40000
+#define MEMTEST_JOB_SLICE	0x100000
+
+/*
+ * AP RAM reserved for TF-A and OP-TEE (see armada-37xx.dtsi), also holding the
+ * DDR training results
+ */
+#define AP_SECURE_BASE		0x04000000
+#define AP_SECURE_END		0x05400000
+
+maybe_unused static u32 cmd_get_random(u32 *args, u32 *out_args, u32 iter)
 {
+	static u32 pos;
+	u32 len;
 	int res;
 
 	if (args[0] == 1) {
-		if (!check_ap_addr(args[1], args[2], 4))
-			return MBOX_STS(0, EINVAL, FAIL);
-
-		res = process_ap_mem(NULL, args[1], args[2], paranoid_rand_ap_cb);
-		if (res < 0)
-			return MBOX_STS(0, -res, FAIL);
+		if (!iter) {
+			if (!check_ap_addr(args[1], args[2], 4) ||
+			    args[1] + args[2] < args[1])
+				return MBOX_STS(0, EINVAL, FAIL);
+			pos = 0;
+		}
+
+		len = MIN(args[2] - pos, RANDOM_JOB_SLICE);
+		if (len) {
+			res = process_ap_mem(NULL, args[1] + pos, len,
+					     paranoid_rand_ap_cb);
+			if (res < 0)
+				return MBOX_STS(0, -res, FAIL);
+			pos += len;
+		}
+
+		if (pos < args[2])
+			return MBOX_STS(0, 0, LATER);
 
 		res = 0xfffff;
 	} else {
@@ -176,42 +206,51 @@ maybe_unused static u32 cmd_ecdsa_pub_key(u32 *args, u32 *out_args)
 	return MBOX_STS(0, pub[0], SUCCESS);
 }
 
+static void hash_ap_cb(void **ctx_p, void *addr, u32 len)
+{
+	hw_hash_update(*ctx_p, addr, len);
+}
+
 /*
  * args[0] = 1, 2, 3, 4, 5, 6 for MD5, SHA1, SHA224, SHA256, SHA384 and SHA512
- * args[1] = address of input, aligned to 4 bytes
+ * args[1] = address of input
  * args[2] = input length
+ *
+ * The input may lie anywhere in AP RAM, also above the first 1 GiB.
  */
-maybe_unused static u32 cmd_hash(u32 *args, u32 *out_args)
-{
-	hw_hash_fnc_t fn;
-
-	switch (args[0]) {
-	case 0x1:
-		fn = hw_md5;
-		break;
-	case 0x2:
-		fn = hw_sha1;
-		break;
-	case 0x3:
-		fn = hw_sha224;
-		break;
-	case 0x4:
-		fn = hw_sha256;
-		break;
-	case 0x5:
-		fn = hw_sha384;
-		break;
-	case 0x6:
-		fn = hw_sha512;
-		break;
-	default:
-		return MBOX_STS(0, EOPNOTSUPP, FAIL);
+maybe_unused static u32 cmd_hash(u32 *args, u32 *out_args, u32 iter)
+{
+	static hash_ctx_t ctx;
+	static u32 pos;
+	u32 len;
+	int res;
+
+	if (!iter) {
+		if (args[2] && (!check_ap_addr(args[1], args[2], 1) ||
+				args[1] + args[2] < args[1]))
+			return MBOX_STS(0, EINVAL, FAIL);
+
+		if (hw_hash_init(&ctx, args[0], args[2]) < 0)
+			return MBOX_STS(0, EOPNOTSUPP, FAIL);
+
+		pos = 0;
 	}
 
-	if (!check_ap_addr(args[1], args[2], 4))
-		return MBOX_STS(0, EINVAL, FAIL);
+	len = MIN(args[2] - pos, HASH_JOB_SLICE);
+	if (len) {
+		res = process_ap_mem(&ctx, args[1] + pos, len, hash_ap_cb);
+		if (res < 0) {
+			hw_hash_final(&ctx, out_args);
+			bzero(out_args, MBOX_MAX_ARGS * sizeof(u32));
+			return MBOX_STS(0, -res, FAIL);
+		}
+		pos += len;
+	}
 
-	fn((void *)AP_RAM(args[1]), args[2], out_args);
+	if (pos < args[2])
+		return MBOX_STS(0, 0, LATER);
+
+	hw_hash_final(&ctx, out_args);
 
 	return MBOX_STS(0, 0, SUCCESS);
 }
@@ -228,6 +267,33 @@ static void array_reverse_u32(u32 *x, int len)
 	}
 }
 
+static int sign_one(u32 msg_addr, u32 r_addr, u32 s_addr)
+{
+	ec_sig_t sig;
+	u32 msg[17];
+	int res;
+
+	/* read src message from AP RAM */
+	res = copy_from_ap(msg, msg_addr, 68);
+	if (res < 0)
+		return res;
+	array_reverse_u32(msg, 17);
+
+	res = ecdsa_sign(&sig, msg);
+	if (res < 0)
+		return res;
+
+	array_reverse_u32(sig.r, 17);
+	res = copy_to_ap(r_addr, sig.r, 68);
+	if (res < 0)
+		return res;
+
+	array_reverse_u32(sig.s, 17);
+	return copy_to_ap(s_addr, sig.s, 68);
+}
+
+#define SIGN_BATCH_MAX	256
+
 /*
  * For ECDSA521
  *   args[0] = 0x1
@@ -235,44 +301,95 @@ static void array_reverse_u32(u32 *x, int len)
  *   args[2] = address of output signature R
  *   args[3] = address of output signature S
  *
+ * For batched ECDSA521
+ *   args[0] = 0x2
+ *   args[1] = address of input array of N messages, 68 bytes each (same format
+ *             as above)
+ *   args[2] = address of output array of N signatures, 136 bytes each (R
+ *             followed by S)
+ *   args[3] = address of output array of N statuses, 4 bytes each (0 on
+ *             success, errno otherwise)
+ *   args[4] = N, at most SIGN_BATCH_MAX
+ *
+ *   returns number of successfully signed messages
+ *
  *   addresses must be aligned to 4 bytes
+ *
+ * For signing statistics
+ *   args[0] = 0x3
+ *
+ *   out_args[0] = number of precomputed nonces currently in pool
+ *   out_args[1] = nonce pool size
+ *   out_args[2] = number of signatures which used a precomputed nonce
+ *   out_args[3] = number of signatures which had to compute the nonce
+ *   out_args[4] = median sign latency in microseconds
+ *   out_args[5] = 99th percentile sign latency in microseconds
  */
-maybe_unused static u32 cmd_sign(u32 *args, u32 *out_args)
+maybe_unused static u32 cmd_sign(u32 *args, u32 *out_args, u32 iter)
 {
-	ec_sig_t sig;
-	u32 msg[17];
+	static u32 signed_cnt;
+	u32 n, status, sig_addr;
 	int res;
 
-	if (args[0] != 0x1)
+	if (args[0] == 0x1) {
+		/* check if src and dst addresses are correctly aligned */
+		if (!check_ap_addr(args[1], 68, 4) ||
+		    !check_ap_addr(args[2], 68, 4) ||
+		    !check_ap_addr(args[3], 68, 4))
+			return MBOX_STS(0, EINVAL, FAIL);
+
+		res = sign_one(args[1], args[2], args[3]);
+		if (res < 0)
+			return MBOX_STS(0, -res, FAIL);
+
+		return MBOX_STS(0, 0, SUCCESS);
+	} else if (args[0] == 0x3) {
+		ecdsa_sign_stats_t stats;
+
+		ecdsa_get_sign_stats(&stats);
+		out_args[0] = stats.pool_depth;
+		out_args[1] = stats.pool_size;
+		out_args[2] = stats.hits;
+		out_args[3] = stats.misses;
+		out_args[4] = stats.lat_p50;
+		out_args[5] = stats.lat_p99;
+
+		return MBOX_STS(0, 0, SUCCESS);
+	} else if (args[0] != 0x2) {
 		return MBOX_STS(0, EOPNOTSUPP, FAIL);
+	}
 
-	/* check if src and dst addresses are correctly aligned */
-	if (!check_ap_addr(args[1], 68, 4) ||
-	    !check_ap_addr(args[2], 68, 4) ||
-	    !check_ap_addr(args[3], 68, 4))
-		return MBOX_STS(0, EINVAL, FAIL);
+	/* batched signing, one message per call */
+	n = args[4];
+	if (!iter) {
+		if (!n || n > SIGN_BATCH_MAX)
+			return MBOX_STS(0, EINVAL, FAIL);
 
-	/* read src message from AP RAM */
-	res = copy_from_ap(msg, args[1], 68);
-	if (res < 0)
-		return MBOX_STS(0, -res, FAIL);
-	array_reverse_u32(msg, 17);
+		if (!check_ap_addr(args[1], n * 68, 4) ||
+		    !check_ap_addr(args[2], n * 136, 4) ||
+		    !check_ap_addr(args[3], n * 4, 4))
+			return MBOX_STS(0, EINVAL, FAIL);
 
-	res = ecdsa_sign(&sig, msg);
-	if (res < 0)
-		return MBOX_STS(0, -res, FAIL);
+		signed_cnt = 0;
+	}
 
-	array_reverse_u32(sig.r, 17);
-	res = copy_to_ap(args[2], sig.r, 68);
-	if (res < 0)
-		return MBOX_STS(0, -res, FAIL);
+	sig_addr = args[2] + iter * 136;
+	res = sign_one(args[1] + iter * 68, sig_addr, sig_addr + 68);
+	if (res < 0) {
+		status = -res;
+	} else {
+		status = 0;
+		++signed_cnt;
+	}
 
-	array_reverse_u32(sig.s, 17);
-	res = copy_to_ap(args[3], sig.s, 68);
+	res = copy_to_ap(args[3] + iter * 4, &status, 4);
 	if (res < 0)
 		return MBOX_STS(0, -res, FAIL);
 
-	return MBOX_STS(0, 0, SUCCESS);
+	if (iter + 1 < n)
+		return MBOX_STS(0, 0, LATER);
+
+	return MBOX_STS(0, signed_cnt, SUCCESS);
 }
 
 maybe_unused static u32 cmd_verify(u32 *args, u32 *out_args)
@@ -480,6 +597,102 @@ maybe_unused static u32 cmd_otp_write_256b(u32 *args, u32 *out_args)
 	return MBOX_STS_MARVELL(0);
 }
 
+/*
+ * args[0] = 0 for global statistics, 1 for queue wait time and 2 for
+ *           execution time histograms of command args[1], 3 to reset
+ * args[1] = command ID
+ *
+ * See stats_read() for the format of the output.
+ */
+maybe_unused static u32 cmd_stats(u32 *args, u32 *out_args)
+{
+	int res;
+
+	res = stats_read(args[0], args[1], out_args);
+	if (res < 0)
+		return MBOX_STS(0, -res, FAIL);
+
+	return MBOX_STS(0, 0, SUCCESS);
+}
+
+/*
+ * out_args[0] = bitmask of reached boot phases (bits 0-15) and boot flags
+ *		 (bits 16-31, see enum boottime_flag)
+ * out_args[1 + i] = timestamp in microseconds of end of boot phase i
+ *
+ * See enum boottime_phase for the phases.
+ */
+maybe_unused static u32 cmd_boottime(u32 *args, u32 *out_args)
+{
+	boottime_read(out_args);
+
+	return MBOX_STS(0, 0, SUCCESS);
+}
+
+/*
+ * out_args[0-15] = telemetry record of DDR training, see struct ddr_telemetry
+ */
+maybe_unused static u32 cmd_ddr_telemetry(u32 *args, u32 *out_args)
+{
+	int res;
+
+	res = ddr_telemetry_read(out_args);
+	if (res < 0)
+		return MBOX_STS(0, -res, FAIL);
+
+	return MBOX_STS(0, 0, SUCCESS);
+}
+
+/*
+ * args[0] = pattern, see enum memtest_pattern
+ * args[1] = address of tested region in AP RAM
+ * args[2] = length of tested region
+ * args[3] = seed of random pattern / moving inversions background, 0 = default
+ *
+ * Address and length must be multiples of 16. The test destroys the content
+ * of the region, which must not be used by AP meanwhile. The region must not
+ * overlap the memory reserved for TF-A and OP-TEE, which also holds the DDR
+ * training results. Only available with MBOX_MEMTEST=1 and without secure
+ * boot.
+ *
+ * out_args[0] = number of failing words
+ * out_args[1] = duration in microseconds
+ * out_args[2] = throughput in MB/s
+ * out_args[3 + 2 * i] = address of i-th failing word
+ * out_args[4 + 2 * i] = failing bits of i-th failing word
+ * status value = number of failing words reported in out_args
+ */
+maybe_unused static u32 cmd_memtest(u32 *args, u32 *out_args, u32 iter)
+{
+	static struct memtest t;
+	int i;
+
+	if (!iter) {
+		if (!check_ap_addr(args[1], args[2], 16) ||
+		    args[1] + args[2] < args[1])
+			return MBOX_STS(0, EINVAL, FAIL);
+
+		if (args[1] < AP_SECURE_END && args[1] + args[2] > AP_SECURE_BASE)
+			return MBOX_STS(0, EACCES, FAIL);
+
+		if (memtest_init(&t, args[0], args[1], args[2], args[3]) < 0)
+			return MBOX_STS(0, EINVAL, FAIL);
+	}
+
+	if (!memtest_step(&t, MEMTEST_JOB_SLICE))
+		return MBOX_STS(0, 0, LATER);
+
+	out_args[0] = t.errors;
+	out_args[1] = t.us;
+	out_args[2] = memtest_rate(&t);
+	for (i = 0; i < t.nlog; ++i) {
+		out_args[3 + 2 * i] = t.log[i].addr;
+		out_args[4 + 2 * i] = t.log[i].xor;
+	}
+
+	return MBOX_STS(0, t.nlog, SUCCESS);
+}
+
 maybe_unused static u32 cmd_reboot(u32 *args, u32 *out_args)
 {
 	if (args[0] == SOC_MBOX_RESET_CMD_MAGIC)
@@ -541,15 +754,28 @@ static void uart_init(const struct uart_info *uart, int reset)
 # define DEPLOY 0
 #endif
 
+#ifndef WITHOUT_STATS
+# define WITHOUT_STATS 0
+#endif
+
+#ifndef MBOX_MEMTEST
+# define MBOX_MEMTEST 0
+#endif
+
 void __attribute__((noreturn)) main(void)
 {
 	enum board board;
+	int can_sign = 0;
+
+	boottime_mark(BOOTTIME_START);
 
 	if (WTMI_APP)
 		uart_init(&uart1_info, 0);
 	else
 		uart_init(get_debug_uart(), 1);
 
+	boottime_mark(BOOTTIME_UART);
+
 	if (DEPLOY) {
 		ebg_init();
 		deploy();
@@ -560,31 +786,57 @@ void __attribute__((noreturn)) main(void)
 	fputs("Running on ", stdout);
 	puts(get_board_name());
 
-	if (!WTMI_APP)
+	if (!WTMI_APP) {
+		/* EBG warm-up does not depend on AVS, do it while it settles */
+		if (!DEPLOY)
+			avs_defer(ebg_init);
+
 		init_ddr();
 
-	if (!DEPLOY)
+		/* in case ddr_main failed before running deferred work */
+		avs_complete();
+		boottime_mark(BOOTTIME_DDR);
+	} else if (!DEPLOY) {
 		ebg_init();
+	}
+
+	boottime_mark(BOOTTIME_EBG);
 
 	enable_systick();
 
 	board = get_board();
-	if (board == Turris_MOX)
+	if (board == Turris_MOX) {
 		soc_init();
+		boottime_mark(BOOTTIME_SOC);
+	}
+
+	stats_init();
+
+	/* serve OTP reads from SRAM */
+	efuse_shadow_fill();
 
 	/* TODO: what do we want to do with the disabled commands */
 	mbox_init();
-	mbox_register_cmd(MBOX_CMD_GET_RANDOM, cmd_get_random);
+	mbox_register_job(MBOX_CMD_GET_RANDOM, cmd_get_random);
+	/* destructive and writes AP chosen data, never with secure boot */
+	if (MBOX_MEMTEST && !is_secure_boot())
+		mbox_register_job(MBOX_CMD_MEMTEST, cmd_memtest);
 
 	if (board == Turris_MOX || board == RIPE_Atlas) {
+		can_sign = 1;
 		mbox_register_cmd(MBOX_CMD_BOARD_INFO, cmd_board_info);
 		mbox_register_cmd(MBOX_CMD_ECDSA_PUB_KEY, cmd_ecdsa_pub_key);
-		/*mbox_register_cmd(MBOX_CMD_HASH, cmd_hash);*/
-		mbox_register_cmd(MBOX_CMD_SIGN, cmd_sign);
+		mbox_register_job(MBOX_CMD_HASH, cmd_hash);
+		mbox_register_job(MBOX_CMD_SIGN, cmd_sign);
 		/*mbox_register_cmd(MBOX_CMD_VERIFY, cmd_verify);*/
 	}
 
 	mbox_register_cmd(MBOX_CMD_REBOOT, cmd_reboot);
+	mbox_register_cmd(MBOX_CMD_BOOTTIME, cmd_boottime);
+	mbox_register_cmd(MBOX_CMD_DDR_TELEMETRY, cmd_ddr_telemetry);
+
+	if (!WITHOUT_STATS)
+		mbox_register_cmd(MBOX_CMD_STATS, cmd_stats);
 
 	if (!WITHOUT_OTP_READ) {
 		mbox_register_cmd(MBOX_CMD_OTP_READ, cmd_otp_read);
@@ -603,24 +855,41 @@ void __attribute__((noreturn)) main(void)
 		mbox_register_cmd(MBOX_CMD_OTP_WRITE_256B, cmd_otp_write_256b);
 	}
 
+	boottime_mark(BOOTTIME_MBOX);
+
 	enable_irq();
 
 	/*
 	 * Start AP immediately only if debugging is disabled.
 	 * If running as application, AP is already running.
 	 */
-	if (!debug_init() && !WTMI_APP)
+	if (!debug_init() && !WTMI_APP) {
 		start_ap_workaround();
+		boottime_mark(BOOTTIME_AP);
+	}
+
+	boottime_mark(BOOTTIME_LOOP);
 
 	while (1) {
 		disable_irq();
-		if (!mbox_has_cmd())
+		if (!mbox_has_cmd() && !mbox_has_pending())
 			wait_for_irq();
 		enable_irq();
 		if (board == Turris_MOX)
 			mox_wdt_workaround();
 		mbox_process_commands();
-		debug_process();
+		/*
+		 * Console commands may reset the hash engine, keep them
+		 * waiting while a hash job is in progress.
+		 */
+		if (!hw_hash_busy())
+			debug_process();
 		ebg_process();
+		/*
+		 * mbox_irq_handler clears CMD_REG_OCCUPIED once it has queued
+		 * the command, so check the queue rather than the register.
+		 */
+		if (can_sign && !mbox_has_pending() && !hw_hash_busy())
+			ecdsa_process();
 	}
 }
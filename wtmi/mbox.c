@@ -4,6 +4,7 @@
 #include "io.h"
 #include "irq.h"
 #include "mbox.h"
+#include "stats.h"
 
 #define MBOX_IN_ARG(n)		(0x40000000 + (n) * 4)
 #define MBOX_IN_CMD		0x40000040
@@ -18,20 +19,38 @@
 #define SP_INT_MASK		0x4000021c
 #define SP_CONTROL		0x40000220
 
-#define CMD_QUEUE_SIZE		8
-
 static mbox_cmd_handler_t cmd_handlers[16];
+static mbox_job_handler_t job_handlers[16];
 static mbox_cmd_handler_t cmd_otp_read_handlers[5];
 static mbox_cmd_handler_t cmd_otp_write_handlers[5];
 
 typedef struct {
 	u16 cmd;
 	u32 args[MBOX_MAX_ARGS];
+	u32 stamp, wait, exec;
 } cmd_request_t;
 
 static cmd_request_t cmd_queue[CMD_QUEUE_SIZE];
 static int cmd_queue_fill, cmd_queue_first;
 
+/*
+ * Long running commands are registered as jobs. A job handler is called
+ * repeatedly from the main loop, one slice of work at a time, until it returns
+ * something other than MBOX_STS_LATER. Other commands are served in between.
+ * Only one job is in progress at a time, so that job handlers can keep their
+ * state in static variables; other job commands wait in the queue.
+ */
+static struct {
+	int active;
+	u32 iter;
+	cmd_request_t req;
+} job;
+
+static int is_job_cmd(u16 cmd)
+{
+	return cmd < ARRAY_SIZE(job_handlers) && job_handlers[cmd];
+}
+
 static int is_marvell_read_cmd(u16 cmd)
 {
 	return cmd >= MBOX_CMD_OTP_READ_1B &&
@@ -59,41 +78,115 @@ static mbox_cmd_handler_t marvell_cmd_handler(u16 cmd)
 		return NULL;
 }
 
-void mbox_process_commands(void)
+static u32 run_cmd(cmd_request_t *req, u32 iter)
+{
+	u32 status, out_args[MBOX_MAX_ARGS], start;
+	int i;
+
+	/* out_args can contain sensitive stack values, rewrite them */
+	for (i = 0; i < MBOX_MAX_ARGS; ++i)
+		out_args[i] = 0;
+
+	start = stats_cycles();
+	if (!iter)
+		req->wait = start - req->stamp;
+
+	if (is_job_cmd(req->cmd)) {
+		status = job_handlers[req->cmd](req->args, out_args, iter);
+		if (MBOX_STS_CMD(status) == 0)
+			status |= req->cmd;
+	} else if (req->cmd < ARRAY_SIZE(cmd_handlers)) {
+		status = cmd_handlers[req->cmd](req->args, out_args);
+		if (MBOX_STS_CMD(status) == 0)
+			status |= req->cmd;
+	} else if (is_marvell_cmd(req->cmd)) {
+		status = marvell_cmd_handler(req->cmd)(req->args, out_args);
+	} else if (req->cmd >= 256) {
+		status = MBOX_STS_MARVELL(ENOSYS);
+	} else {
+		status = MBOX_STS(req->cmd, 0, BADCMD);
+	}
+
+	req->exec += stats_cycles() - start;
+
+	if (MBOX_STS_ERROR(status) != MBOX_STS_LATER) {
+		stats_cmd_done(req->cmd, req->wait, req->exec);
+		mbox_send(status, out_args);
+	}
+
+	return status;
+}
+
+static void cmd_queue_remove(int idx)
 {
-	while (cmd_queue_fill > 0) {
+	int i;
+
+	/*
+	 * Move the entries before idx one place forward, so that the tail of
+	 * the queue, where mbox_irq_handler appends, stays in place.
+	 */
+	disable_irq();
+	for (i = idx; i > 0; --i)
+		cmd_queue[(cmd_queue_first + i) % CMD_QUEUE_SIZE] =
+			cmd_queue[(cmd_queue_first + i - 1) % CMD_QUEUE_SIZE];
+	cmd_queue_first = (cmd_queue_first + 1) % CMD_QUEUE_SIZE;
+	--cmd_queue_fill;
+	enable_irq();
+}
+
+static void process_queue(void)
+{
+	int i = 0;
+
+	while (i < cmd_queue_fill) {
 		cmd_request_t *req;
-		u32 status, out_args[MBOX_MAX_ARGS];
-		int i;
+		u32 status;
 
-		/* out_args can contain sensitive stack values, rewrite them */
-		for (i = 0; i < MBOX_MAX_ARGS; ++i)
-			out_args[i] = 0;
-
-		req = &cmd_queue[cmd_queue_first];
-
-		if (req->cmd < ARRAY_SIZE(cmd_handlers)) {
-			status = cmd_handlers[req->cmd](req->args, out_args);
-			if (MBOX_STS_CMD(status) == 0)
-				status |= req->cmd;
-		} else if (is_marvell_cmd(req->cmd)) {
-			status = marvell_cmd_handler(req->cmd)(req->args, out_args);
-		} else if (req->cmd >= 256) {
-			status = MBOX_STS_MARVELL(ENOSYS);
-		} else {
-			status = MBOX_STS(req->cmd, 0, BADCMD);
+		req = &cmd_queue[(cmd_queue_first + i) % CMD_QUEUE_SIZE];
+
+		/* another job is in progress, this one has to wait */
+		if (is_job_cmd(req->cmd) && job.active) {
+			++i;
+			continue;
 		}
 
-		if (MBOX_STS_ERROR(status) != MBOX_STS_LATER)
-			mbox_send(status, out_args);
+		status = run_cmd(req, 0);
+		if (is_job_cmd(req->cmd) &&
+		    MBOX_STS_ERROR(status) == MBOX_STS_LATER) {
+			job.req = *req;
+			job.iter = 1;
+			job.active = 1;
+		}
 
-		disable_irq();
-		cmd_queue_first = (cmd_queue_first + 1) % CMD_QUEUE_SIZE;
-		--cmd_queue_fill;
-		enable_irq();
+		cmd_queue_remove(i);
 	}
 }
 
+void mbox_process_commands(void)
+{
+	while (1) {
+		process_queue();
+
+		if (!job.active)
+			break;
+
+		if (MBOX_STS_ERROR(run_cmd(&job.req, job.iter)) ==
+		    MBOX_STS_LATER) {
+			++job.iter;
+			break;
+		}
+
+		/* job is done, start another one if waiting in the queue */
+		job.active = 0;
+	}
+}
+
+/* commands queued by mbox_irq_handler or a job in progress */
+int mbox_has_pending(void)
+{
+	return cmd_queue_fill || job.active;
+}
+
 int mbox_has_cmd(void)
 {
 	return !!(readl(SP_CONTROL) & CMD_REG_OCCUPIED_BIT);
@@ -108,6 +201,7 @@ void mbox_irq_handler(int irq)
 		return;
 
 	if (cmd_queue_fill == CMD_QUEUE_SIZE) {
+		stats_queue_full();
 		setbitsl(HOST_INT_SET, HOST_INT_CMD_QUEUE_FULL_ACCESS,
 			 HOST_INT_CMD_QUEUE_FULL_ACCESS);
 		goto clear_irq;
@@ -116,7 +210,7 @@ void mbox_irq_handler(int irq)
 	cmd = readl(MBOX_IN_CMD) & MBOX_CMD_MASK;
 
 	if ((cmd < ARRAY_SIZE(cmd_handlers) && cmd_handlers[cmd]) ||
-	    marvell_cmd_handler(cmd)) {
+	    is_job_cmd(cmd) || marvell_cmd_handler(cmd)) {
 		cmd_request_t *req;
 
 		req = &cmd_queue[(cmd_queue_first + cmd_queue_fill) % CMD_QUEUE_SIZE];
@@ -124,8 +218,11 @@ void mbox_irq_handler(int irq)
 		req->cmd = cmd;
 		for (i = 0; i < MBOX_MAX_ARGS; ++i)
 			req->args[i] = readl(MBOX_IN_ARG(i));
+		req->stamp = stats_cycles();
+		req->exec = 0;
 
 		++cmd_queue_fill;
+		stats_queue_depth(cmd_queue_fill);
 	} else if (cmd >= 256) {
 		mbox_send(MBOX_STS_MARVELL(ENOSYS), NULL);
 	} else {
@@ -151,7 +248,8 @@ void mbox_init(void)
 
 void mbox_register_cmd(u16 cmd, mbox_cmd_handler_t handler)
 {
-	if (cmd < ARRAY_SIZE(cmd_handlers) && !cmd_handlers[cmd])
+	if (cmd < ARRAY_SIZE(cmd_handlers) && !cmd_handlers[cmd] &&
+	    !job_handlers[cmd])
 		cmd_handlers[cmd] = handler;
 	else if (is_marvell_read_cmd(cmd) && !marvell_cmd_handler(cmd))
 		cmd_otp_read_handlers[cmd - MBOX_CMD_OTP_READ_1B] = handler;
@@ -159,9 +257,17 @@ void mbox_register_cmd(u16 cmd, mbox_cmd_handler_t handler)
 		cmd_otp_write_handlers[cmd - MBOX_CMD_OTP_WRITE_1B] = handler;
 }
 
+void mbox_register_job(u16 cmd, mbox_job_handler_t handler)
+{
+	if (cmd < ARRAY_SIZE(job_handlers) && !cmd_handlers[cmd] &&
+	    !job_handlers[cmd])
+		job_handlers[cmd] = handler;
+}
+
 void mbox_send(u32 status, u32 *args)
 {
-	int i;
+	u32 spin_start = 0;
+	int i, spun = 0;
 
 	/*
 	 * If AP did not read previous message yet, we must wait til it does.
@@ -176,9 +282,17 @@ void mbox_send(u32 status, u32 *args)
 		else
 			break;
 
+		if (!spun) {
+			spin_start = stats_cycles();
+			spun = 1;
+		}
+
 		udelay(100);
 	}
 
+	if (spun)
+		stats_send_spin(stats_cycles() - spin_start);
+
 	if (args) {
 		for (i = 0; i < MBOX_MAX_ARGS; i++)
 			writel(args[i], MBOX_OUT_ARG(i));
@@ -2,6 +2,7 @@
 #define _MBOX_H_
 
 #define MBOX_MAX_ARGS			16
+#define CMD_QUEUE_SIZE			8
 #define MBOX_CMD_MASK			0x0000FFFF
 
 #define CMD_REG_OCCUPIED_RESET_BIT	BIT(1)
@@ -32,6 +33,10 @@ enum mbox_cmd {
 	MBOX_CMD_OTP_WRITE,
 
 	MBOX_CMD_REBOOT,
+	MBOX_CMD_STATS,
+	MBOX_CMD_BOOTTIME,
+	MBOX_CMD_DDR_TELEMETRY,
+	MBOX_CMD_MEMTEST,
 
 	/* OTP read commands supported by Marvell's fuse.bin firmware */
 	MBOX_CMD_OTP_READ_1B	= 257,
@@ -50,9 +55,17 @@ enum mbox_cmd {
 
 typedef u32 (*mbox_cmd_handler_t)(u32 *in_args, u32 *out_args);
 
+/*
+ * Handler of a long running command. It is called with iter = 0, 1, 2, ...
+ * from the main loop as long as it returns MBOX_STS_LATER.
+ */
+typedef u32 (*mbox_job_handler_t)(u32 *in_args, u32 *out_args, u32 iter);
+
 extern void mbox_init(void);
 extern void mbox_register_cmd(u16 cmd, mbox_cmd_handler_t handler);
+extern void mbox_register_job(u16 cmd, mbox_job_handler_t handler);
 extern int mbox_has_cmd(void);
+extern int mbox_has_pending(void);
 extern void mbox_process_commands(void);
 extern void mbox_send(u32 status, u32 *args);
 
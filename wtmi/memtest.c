@@ -0,0 +1,348 @@
+#include "types.h"
+#include "io.h"
+#include "clock.h"
+#include "ddr.h"
+#include "errno.h"
+#include "memtest.h"
+#include "string.h"
+#include "stdio.h"
+#include "div64.h"
+#include "debug.h"
+
+/*
+ * Memory test engine. A test is a sequence of march elements, each going over
+ * the whole region up or down, optionally checking the data it expects to
+ * find and then writing new data. Memory is accessed in 16 byte LDM/STM
+ * bursts through CM3 DRAM window 0, which is remapped for regions above the
+ * first 1 GiB. Down elements go over the bursts in descending order, but the
+ * words within a burst are always accessed in ascending order.
+ *
+ * memtest_step() does a limited amount of work at a time, so that a test can
+ * run as a mailbox job without blocking other commands for too long.
+ */
+
+enum memtest_data {
+	MT_NONE = 0,
+	MT_BG,		/* background pattern */
+	MT_NBG,		/* inverted background */
+	MT_ADDR,	/* address of the word */
+	MT_NADDR,	/* inverted address */
+	MT_WALK1,	/* one bit set, position given by the address */
+	MT_WALK0,	/* one bit clear, position given by the address */
+	MT_RAND,	/* xorshift sequence started from the seed */
+};
+
+struct memtest_elem {
+	u8 down;
+	u8 rd;		/* data expected before writing, MT_NONE to not check */
+	u8 wr;		/* data written, MT_NONE to not write */
+};
+
+static const struct memtest_elem address_elems[] = {
+	{ 0, MT_NONE, MT_ADDR },
+	{ 0, MT_ADDR, MT_NADDR },
+	{ 0, MT_NADDR, MT_NONE },
+};
+
+/*
+ * Each word sees its walking bit both set and cleared, so that a stuck bit is
+ * found also at the position of the walking one.
+ */
+static const struct memtest_elem walk1_elems[] = {
+	{ 0, MT_NONE, MT_WALK1 },
+	{ 0, MT_WALK1, MT_WALK0 },
+	{ 0, MT_WALK0, MT_NONE },
+};
+
+static const struct memtest_elem walk0_elems[] = {
+	{ 0, MT_NONE, MT_WALK0 },
+	{ 0, MT_WALK0, MT_WALK1 },
+	{ 0, MT_WALK1, MT_NONE },
+};
+
+/* March C-, with all zeros background */
+static const struct memtest_elem march_c_elems[] = {
+	{ 0, MT_NONE, MT_BG },
+	{ 0, MT_BG, MT_NBG },
+	{ 0, MT_NBG, MT_BG },
+	{ 1, MT_BG, MT_NBG },
+	{ 1, MT_NBG, MT_BG },
+	{ 0, MT_BG, MT_NONE },
+};
+
+static const struct memtest_elem moving_inv_elems[] = {
+	{ 0, MT_NONE, MT_BG },
+	{ 0, MT_BG, MT_NBG },
+	{ 1, MT_NBG, MT_BG },
+	{ 0, MT_BG, MT_NONE },
+};
+
+static const struct memtest_elem random_elems[] = {
+	{ 0, MT_NONE, MT_RAND },
+	{ 0, MT_RAND, MT_NONE },
+};
+
+static const struct {
+	const char *name;
+	const struct memtest_elem *elems;
+	int nelems;
+} memtest_patterns[MEMTEST_PATTERNS] = {
+#define PATTERN(p, n, e) [p] = { n, e, ARRAY_SIZE(e) }
+	PATTERN(MEMTEST_ADDRESS, "addr", address_elems),
+	PATTERN(MEMTEST_WALKING_ONES, "walk1", walk1_elems),
+	PATTERN(MEMTEST_WALKING_ZEROS, "walk0", walk0_elems),
+	PATTERN(MEMTEST_MARCH_C, "march", march_c_elems),
+	PATTERN(MEMTEST_MOVING_INV, "movinv", moving_inv_elems),
+	PATTERN(MEMTEST_RANDOM, "random", random_elems),
+#undef PATTERN
+};
+
+const char *memtest_name(enum memtest_pattern pattern)
+{
+	return memtest_patterns[pattern].name;
+}
+
+static inline void burst_read(volatile u32 *p, u32 *v)
+{
+	asm volatile("ldmia %1, {r3-r6}\n\t"
+		     "stmia %0, {r3-r6}"
+		     :
+		     : "r" (v), "r" (p)
+		     : "r3", "r4", "r5", "r6", "memory");
+}
+
+static inline void burst_write(volatile u32 *p, const u32 *v)
+{
+	asm volatile("ldmia %1, {r3-r6}\n\t"
+		     "stmia %0, {r3-r6}"
+		     :
+		     : "r" (p), "r" (v)
+		     : "r3", "r4", "r5", "r6", "memory");
+}
+
+static inline u32 memtest_data(struct memtest *t, u8 kind, u32 addr)
+{
+	switch (kind) {
+	case MT_BG:
+		return t->bg;
+	case MT_NBG:
+		return ~t->bg;
+	case MT_ADDR:
+		return addr;
+	case MT_NADDR:
+		return ~addr;
+	case MT_WALK1:
+		return BIT((addr >> 2) & 31);
+	case MT_WALK0:
+		return ~BIT((addr >> 2) & 31);
+	case MT_RAND:
+		t->rand ^= t->rand << 13;
+		t->rand ^= t->rand >> 17;
+		t->rand ^= t->rand << 5;
+		return t->rand;
+	default:
+		return 0;
+	}
+}
+
+static void memtest_error(struct memtest *t, u32 addr, u32 xor)
+{
+	if (t->nlog < MEMTEST_MAX_ERRORS) {
+		t->log[t->nlog].addr = addr;
+		t->log[t->nlog].xor = xor;
+		++t->nlog;
+	}
+
+	++t->errors;
+}
+
+/* run element e over n bytes at p, which is DRAM address addr */
+static void memtest_run(struct memtest *t, const struct memtest_elem *e,
+			volatile u32 *p, u32 addr, u32 n)
+{
+	int i, step = 4;
+	u32 v[4], exp;
+
+	if (e->down) {
+		p += n / 4 - 4;
+		addr += n - 16;
+		step = -4;
+	}
+
+	if (e->rd)
+		t->bytes += n;
+	if (e->wr)
+		t->bytes += n;
+
+	for (; n; n -= 16, p += step, addr += step * 4) {
+		if (e->rd) {
+			burst_read(p, v);
+			for (i = 0; i < 4; ++i) {
+				exp = memtest_data(t, e->rd, addr + 4 * i);
+				if (v[i] != exp)
+					memtest_error(t, addr + 4 * i,
+						      v[i] ^ exp);
+			}
+		}
+
+		if (e->wr) {
+			for (i = 0; i < 4; ++i)
+				v[i] = memtest_data(t, e->wr, addr + 4 * i);
+			burst_write(p, v);
+		}
+	}
+}
+
+/*
+ * Prepare test of len bytes of DRAM at base. seed is the seed of the random
+ * pattern, or the background of moving inversions; 0 selects a default.
+ */
+int memtest_init(struct memtest *t, enum memtest_pattern pattern, u32 base,
+		 u32 len, u32 seed)
+{
+	if (pattern >= MEMTEST_PATTERNS || !len || (base | len) % 16 ||
+	    base + len < base)
+		return -EINVAL;
+
+	memset(t, 0, sizeof(*t));
+	t->base = base;
+	t->len = len;
+	t->pattern = pattern;
+	t->elems = memtest_patterns[pattern].elems;
+	t->nelems = memtest_patterns[pattern].nelems;
+	t->seed = seed ? seed : 0x2545f491;
+
+	if (pattern == MEMTEST_MOVING_INV)
+		t->bg = seed ? seed : 0x55555555;
+
+	return 0;
+}
+
+/*
+ * Go over at most budget bytes of the region, counted over all elements.
+ * Returns 1 when the whole test is done, 0 if more steps are needed.
+ */
+int memtest_step(struct memtest *t, u32 budget)
+{
+	u32 start = get_timer_us();
+
+	budget = MAX(budget & ~15, 16U);
+
+	while (budget && t->elem < t->nelems) {
+		const struct memtest_elem *e = &t->elems[t->elem];
+		u32 addr, win, n;
+
+		if (!t->done)
+			t->rand = t->seed;
+
+		/* do not cross the 1 GiB boundaries of window remapping */
+		n = MIN(budget, t->len - t->done);
+		if (e->down) {
+			addr = t->base + t->len - t->done;
+			n = MIN(n, ((addr - 1) & 0x3fffffff) + 1);
+			addr -= n;
+		} else {
+			addr = t->base + t->done;
+			n = MIN(n, 0x40000000 - (addr & 0x3fffffff));
+		}
+
+		win = addr & 0xc0000000;
+		if (win)
+			rwtm_win_remap(0, win);
+
+		memtest_run(t, e, (volatile u32 *)AP_RAM(addr - win), addr, n);
+
+		if (win)
+			rwtm_win_remap(0, 0);
+
+		budget -= n;
+		t->done += n;
+		if (t->done == t->len) {
+			t->done = 0;
+			++t->elem;
+		}
+	}
+
+	t->us += get_timer_us() - start;
+
+	return t->elem == t->nelems;
+}
+
+/* throughput in MB/s */
+u32 memtest_rate(const struct memtest *t)
+{
+	u64 bytes = t->bytes;
+
+	do_div(bytes, MAX(t->us, 1U));
+
+	return bytes;
+}
+
+static void memtest_console(enum memtest_pattern pattern, u32 base, u32 len,
+			    u32 seed)
+{
+	struct memtest t;
+	int i;
+
+	if (memtest_init(&t, pattern, base, len, seed) < 0) {
+		printf("Address and length must be multiples of 16\n");
+		return;
+	}
+
+	while (!memtest_step(&t, 0x1000000))
+		printf("\r%-6s element %d/%d, %u MiB", memtest_name(pattern),
+		       t.elem + 1, t.nelems, t.done >> 20);
+
+	printf("\r%-6s %u errors, %u MB/s                \n",
+	       memtest_name(pattern), t.errors, memtest_rate(&t));
+
+	for (i = 0; i < t.nlog; ++i)
+		printf("  at 0x%08x bits 0x%08x\n", t.log[i].addr,
+		       t.log[i].xor);
+}
+
+DECL_DEBUG_CMD(ddrtest)
+{
+	u32 base = 0, len, seed = 0, ram_size;
+	int pattern = MEMTEST_ADDRESS, all = 0;
+
+	ram_size = get_ram_size();
+	len = ram_size >= 4096 ? 0xfffffff0 : ram_size << 20;
+
+	if (argc > 1) {
+		if (!strcmp(argv[1], "all")) {
+			all = 1;
+		} else {
+			for (pattern = 0; pattern < MEMTEST_PATTERNS; ++pattern)
+				if (!strcmp(argv[1], memtest_name(pattern)))
+					break;
+
+			if (pattern == MEMTEST_PATTERNS)
+				goto usage;
+		}
+	}
+
+	if (argc == 3 || argc > 5)
+		goto usage;
+	if (argc > 3 && (number(argv[2], &base) || number(argv[3], &len)))
+		goto usage;
+	if (argc > 4 && number(argv[4], &seed))
+		goto usage;
+
+	if (all) {
+		for (pattern = 0; pattern < MEMTEST_PATTERNS; ++pattern)
+			memtest_console(pattern, base, len, seed);
+	} else {
+		memtest_console(pattern, base, len, seed);
+	}
+
+	return;
+usage:
+	printf("usage: ddrtest [pattern|all] [address length [seed]]\n");
+	printf("patterns:");
+	for (pattern = 0; pattern < MEMTEST_PATTERNS; ++pattern)
+		printf(" %s", memtest_name(pattern));
+	printf("\ndefault is addr over all RAM\n");
+}
+
+DEBUG_CMD("ddrtest", "DDR memory test", ddrtest);
@@ -0,0 +1,49 @@
+#ifndef _MEMTEST_H_
+#define _MEMTEST_H_
+
+#include "types.h"
+
+/* The values are part of the MBOX_CMD_MEMTEST interface. */
+enum memtest_pattern {
+	MEMTEST_ADDRESS = 0,
+	MEMTEST_WALKING_ONES,
+	MEMTEST_WALKING_ZEROS,
+	MEMTEST_MARCH_C,
+	MEMTEST_MOVING_INV,
+	MEMTEST_RANDOM,
+	MEMTEST_PATTERNS,
+};
+
+/* how many failing words are recorded */
+#define MEMTEST_MAX_ERRORS	6
+
+struct memtest_elem;
+
+struct memtest {
+	/* region in DRAM (AP physical address), aligned to 16 bytes */
+	u32 base, len;
+	u32 seed;
+	enum memtest_pattern pattern;
+
+	/* progress */
+	const struct memtest_elem *elems;
+	int nelems, elem;
+	u32 done, rand, bg;
+
+	/* results */
+	u32 errors, us;
+	u64 bytes;
+	int nlog;
+	struct {
+		u32 addr;
+		u32 xor;
+	} log[MEMTEST_MAX_ERRORS];
+};
+
+extern int memtest_init(struct memtest *t, enum memtest_pattern pattern,
+			u32 base, u32 len, u32 seed);
+extern int memtest_step(struct memtest *t, u32 budget);
+extern u32 memtest_rate(const struct memtest *t);
+extern const char *memtest_name(enum memtest_pattern pattern);
+
+#endif /* _MEMTEST_H_ */
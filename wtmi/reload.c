@@ -7,9 +7,10 @@
 
 #include "reload_helper/reload_helper.c"
 
-void do_reload(void *addr, u32 len)
+static void _do_reload(void *addr, u32 len, u32 check, u32 crc)
 {
-	void __attribute__((noreturn)) (*reload_helper)(const void *src, u32 len);
+	void __attribute__((noreturn)) (*reload_helper)(const void *src, u32 len,
+							u32 check, u32 crc);
 
 	memcpy((void *)RELOAD_HELPER_ADDR, reload_helper_code, sizeof(reload_helper_code));
 	disable_irq();
@@ -17,12 +18,23 @@ void do_reload(void *addr, u32 len)
 
 	/* plus 1 for thumb mode */
 	reload_helper = (void *)(RELOAD_HELPER_ADDR + 1);
-	reload_helper((void *)addr, len);
+	reload_helper((void *)addr, len, check, crc);
+}
+
+void do_reload(void *addr, u32 len)
+{
+	_do_reload(addr, len, 0, 0);
+}
+
+/* the helper halts if the copied image does not match crc (standard CRC32) */
+void do_reload_verified(void *addr, u32 len, u32 crc)
+{
+	_do_reload(addr, len, 1, crc);
 }
 
 DECL_DEBUG_CMD(reload)
 {
-	u32 addr, len;
+	u32 addr, len, crc;
 
 	if (argc < 3)
 		return;
@@ -30,8 +42,14 @@ DECL_DEBUG_CMD(reload)
 	if (number(argv[1], &addr) || number(argv[2], &len))
 		return;
 
+	if (argc > 3 && number(argv[3], &crc))
+		return;
+
 	printf("Reloading secure firmware\n");
-	do_reload((void *)addr, len);
+	if (argc > 3)
+		do_reload_verified((void *)addr, len, crc);
+	else
+		do_reload((void *)addr, len);
 }
 
 DEBUG_CMD("reload", "reload secure-firmware", reload);
@@ -4,5 +4,6 @@
 #include "types.h"
 
 extern void do_reload(void *addr, u32 len);
+extern void do_reload_verified(void *addr, u32 len, u32 crc);
 
 #endif /* _RELOAD_H_ */
@@ -2,15 +2,35 @@
 
 #define DEST_ADDR		0x1fff0000
 
-void reload(const void *src, u32 len)
+/*
+ * Copy the new firmware (len is rounded up to whole words) and, if check is
+ * set, verify that the copy has the expected CRC32. There is no way back if the
+ * check fails, since the old firmware is overwritten by then, so halt.
+ */
+void reload(const void *src, u32 len, u32 check, u32 crc)
 {
 	static void __attribute__((noreturn)) (*jump_to)(void);
-	const u8 *s = (u8 *)src;
-	u8 *d = (u8 *)DEST_ADDR;
+	const u32 *s = src;
+	u32 *d = (u32 *)DEST_ADDR;
+	u32 i, c;
 
-	while (len) {
-		*d++ = *s++;
-		--len;
+	for (i = 0; i < (len + 3) / 4; ++i)
+		d[i] = s[i];
+
+	if (check) {
+		const u8 *p = (const u8 *)DEST_ADDR;
+		int k;
+
+		c = 0xffffffff;
+		for (i = 0; i < len; ++i) {
+			c ^= p[i];
+			for (k = 0; k < 8; ++k)
+				c = (c >> 1) ^ (0xedb88320 & -(c & 1));
+		}
+
+		if (~c != crc)
+			while (1)
+				asm volatile("wfi");
 	}
 
 	jump_to = (void *) (*(u32 *)(DEST_ADDR + 4));
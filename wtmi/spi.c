@@ -3,6 +3,8 @@
 #include "clock.h"
 #include "spi.h"
 #include "string.h"
+#include "errno.h"
+#include "div64.h"
 #include "debug.h"
 
 #define NB_TBG_SEL		0xc0013000
@@ -15,12 +17,24 @@
 #define SPI_CTRL		0xc0010600
 #define SPI_CTRL_RDY		BIT(1)
 #define SPI_CFG			0xc0010604
+#define SPI_CFG_BYTE_LEN	BIT(5)
+#define SPI_CFG_DATA_PIN0	BIT(10)
 #define SPI_DOUT		0xc0010608
 #define SPI_DIN			0xc001060c
 
 #define SPINOR_OP_RDID		0x9f
 #define SPINOR_OP_READ		0x03
 #define SPINOR_OP_READ_FAST	0x0b
+#define SPINOR_OP_READ_1_1_2	0x3b
+#define SPINOR_OP_WREN		0x06
+#define SPINOR_OP_RDSR		0x05
+#define SPINOR_OP_PP		0x02
+#define SPINOR_OP_BE_4K		0x20
+
+#define SR_WIP			BIT(0)
+#define SR_WEL			BIT(1)
+
+#define SPINOR_PAGE_SIZE	256
 
 const struct spi nordev = {
 	.cs = 0,
@@ -78,7 +92,13 @@ static int is_aligned_4(const void *p)
 static inline void spi_4byte(int enable)
 {
 	spi_ctrl_wait_bit(SPI_CTRL_RDY);
-	setbitsl(SPI_CFG, enable ? BIT(5) : 0, BIT(5));
+	setbitsl(SPI_CFG, enable ? SPI_CFG_BYTE_LEN : 0, SPI_CFG_BYTE_LEN);
+}
+
+static inline void spi_dual(int enable)
+{
+	spi_ctrl_wait_bit(SPI_CTRL_RDY);
+	setbitsl(SPI_CFG, enable ? SPI_CFG_DATA_PIN0 : 0, SPI_CFG_DATA_PIN0);
 }
 
 static inline void spi_out(u32 c)
@@ -136,6 +156,41 @@ static void spi_xfer(void *din, const void *dout, u32 len)
 	}
 }
 
+/* read with 4-byte transfers for the word aligned bulk */
+static void spi_read(void *din, u32 len)
+{
+	u8 *pin = din;
+
+	while (!is_aligned_4(pin) && len) {
+		spi_xfer(pin++, NULL, 1);
+		--len;
+	}
+
+	if (len > 4) {
+		u32 *pin4 = (u32 *)pin;
+
+		/* enable 4-byte mode */
+		spi_4byte(1);
+
+		while (len > 4) {
+			spi_ctrl_wait_bit(SPI_CTRL_RDY);
+			writel(0, SPI_DOUT);
+
+			spi_ctrl_wait_bit(SPI_CTRL_RDY);
+			*pin4++ = readl(SPI_DIN);
+
+			len -= 4;
+		}
+
+		pin = (u8 *)pin4;
+
+		/* disable 4-byte mode */
+		spi_4byte(0);
+	}
+
+	spi_xfer(pin, NULL, len);
+}
+
 static void spi_flash_cmd_rw(const struct spi *spi, const void *cmd, u32 cmdlen,
 			     void *din, const void *dout, u32 datalen)
 {
@@ -158,17 +213,156 @@ void spi_nor_read_id(const struct spi *spi, u8 *id)
 	spi_flash_cmd(spi, SPINOR_OP_RDID, id, 6);
 }
 
+/*
+ * Dual output read (1-1-2) is supported by all the SPI NOR vendors below, and
+ * does not need any configuration of the flash. It is not enabled by default,
+ * only by "sf mode dual", and only if the first 256 bytes read the same as
+ * with a single line read.
+ */
+static const u8 spi_nor_dual_vendors[] = {
+	0x01,	/* Spansion */
+	0x20,	/* Micron */
+	0xc2,	/* Macronix */
+	0xc8,	/* GigaDevice */
+	0xef,	/* Winbond */
+};
+
+static int spi_nor_dual;
+
+static int spi_nor_set_dual(const struct spi *spi, int enable)
+{
+	u32 single[64], dual[64];
+	u8 id[6];
+	int i;
+
+	spi_nor_dual = 0;
+	if (!enable)
+		return 0;
+
+	spi_nor_read_id(spi, id);
+	for (i = 0; i < sizeof(spi_nor_dual_vendors); ++i)
+		if (id[0] == spi_nor_dual_vendors[i])
+			break;
+
+	if (i == sizeof(spi_nor_dual_vendors))
+		return -EOPNOTSUPP;
+
+	/* only use dual reads if they return the same data as single ones */
+	spi_nor_read(spi, single, 0, sizeof(single));
+	spi_nor_dual = 1;
+	spi_nor_read(spi, dual, 0, sizeof(dual));
+
+	if (memcmp(single, dual, sizeof(single))) {
+		spi_nor_dual = 0;
+		return -EIO;
+	}
+
+	return 0;
+}
+
 void spi_nor_read(const struct spi *spi, void *dst, u32 pos, u32 len)
 {
 	u8 op[5];
 
-	op[0] = SPINOR_OP_READ_FAST;
+	op[0] = spi_nor_dual ? SPINOR_OP_READ_1_1_2 : SPINOR_OP_READ_FAST;
 	op[1] = pos >> 16;
 	op[2] = pos >> 8;
 	op[3] = pos;
 	op[4] = 0xff;
 
-	spi_flash_cmd_rw(spi, op, sizeof(op), dst, NULL, len);
+	spi_cs_activate(spi);
+
+	spi_xfer(NULL, op, sizeof(op));
+
+	if (len) {
+		if (spi_nor_dual)
+			spi_dual(1);
+
+		spi_read(dst, len);
+
+		if (spi_nor_dual)
+			spi_dual(0);
+	}
+
+	spi_cs_deactivate(spi);
+}
+
+static int spi_nor_wait_ready(const struct spi *spi, u32 timeout_us)
+{
+	u32 start = get_timer_us();
+	u8 sr;
+
+	do {
+		spi_flash_cmd(spi, SPINOR_OP_RDSR, &sr, 1);
+		if (!(sr & SR_WIP))
+			return 0;
+	} while (get_timer_us() - start < timeout_us);
+
+	return -ETIMEDOUT;
+}
+
+static int spi_nor_write_enable(const struct spi *spi)
+{
+	u8 sr;
+
+	spi_flash_cmd(spi, SPINOR_OP_WREN, NULL, 0);
+	spi_flash_cmd(spi, SPINOR_OP_RDSR, &sr, 1);
+
+	/* WEL stays clear if the flash is write protected */
+	return (sr & SR_WEL) ? 0 : -EACCES;
+}
+
+static void spi_nor_addr_op(u8 *op, u8 cmd, u32 pos)
+{
+	op[0] = cmd;
+	op[1] = pos >> 16;
+	op[2] = pos >> 8;
+	op[3] = pos;
+}
+
+/* erase the 4 KiB sector containing pos */
+int spi_nor_erase_4k(const struct spi *spi, u32 pos)
+{
+	u8 op[4];
+	int ret;
+
+	ret = spi_nor_write_enable(spi);
+	if (ret < 0)
+		return ret;
+
+	spi_nor_addr_op(op, SPINOR_OP_BE_4K, pos);
+	spi_flash_cmd_rw(spi, op, sizeof(op), NULL, NULL, 0);
+
+	return spi_nor_wait_ready(spi, 1000000);
+}
+
+/* program already erased flash, page by page */
+int spi_nor_write(const struct spi *spi, const void *src, u32 pos, u32 len)
+{
+	const u8 *p = src;
+	u8 op[4];
+	int ret;
+
+	while (len) {
+		u32 wr = MIN(len, SPINOR_PAGE_SIZE - (pos % SPINOR_PAGE_SIZE));
+
+		ret = spi_nor_write_enable(spi);
+		if (ret < 0)
+			return ret;
+
+		spi_nor_addr_op(op, SPINOR_OP_PP, pos);
+		spi_flash_cmd_rw(spi, op, sizeof(op), NULL, p, wr);
+
+		ret = spi_nor_wait_ready(spi, 10000);
+		if (ret < 0)
+			return ret;
+
+		p += wr;
+		pos += wr;
+		len -= wr;
+	}
+
+	return 0;
 }
 
 DECL_DEBUG_CMD(cmd_spi)
@@ -253,6 +447,27 @@ usage:
 
 DEBUG_CMD("spi", "SPI utility", cmd_spi);
 
+static void sf_bench(u32 pos, u32 len, u32 block)
+{
+	u32 buf[64], start, us, done, rd;
+	u64 rate;
+
+	block = MIN(MAX(block, 1U), sizeof(buf));
+
+	start = get_timer_us();
+	for (done = 0; done < len; done += rd) {
+		rd = MIN(len - done, block);
+		spi_nor_read(&nordev, buf, pos + done, rd);
+	}
+	us = get_timer_us() - start;
+
+	rate = (u64)len * 1000000;
+	do_div(rate, MAX(us, 1U));
+
+	printf("%s read, block 0x%x: 0x%x bytes in %u us, %llu bytes/s\n",
+	       spi_nor_dual ? "dual" : "single", block, len, us, rate);
+}
+
 DECL_DEBUG_CMD(cmd_sf)
 {
 	spi_init(&nordev);
@@ -298,6 +513,32 @@ DECL_DEBUG_CMD(cmd_sf)
 			addr += rd;
 		}
 		printf("\r%x read\n", total);
+	} else if (!strcmp(argv[1], "bench")) {
+		u32 pos = 0, len = 0x100000, block = 256;
+
+		if (argc > 2 && number(argv[2], &pos))
+			goto usage;
+		if (argc > 3 && number(argv[3], &len))
+			goto usage;
+		if (argc > 4 && number(argv[4], &block))
+			goto usage;
+
+		sf_bench(pos, len, block);
+	} else if (!strcmp(argv[1], "mode")) {
+		if (argc < 3) {
+			printf("%s\n", spi_nor_dual ? "dual" : "single");
+		} else if (!strcmp(argv[2], "single")) {
+			spi_nor_set_dual(&nordev, 0);
+		} else if (!strcmp(argv[2], "dual")) {
+			int res = spi_nor_set_dual(&nordev, 1);
+
+			if (res == -EIO)
+				printf("Dual read does not match single read\n");
+			else if (res < 0)
+				printf("Dual read not supported by this flash\n");
+		} else {
+			goto usage;
+		}
 	} else {
 		goto usage;
 	}
@@ -306,6 +547,8 @@ DECL_DEBUG_CMD(cmd_sf)
 usage:
 	printf("usage: sf id\n");
 	printf("       sf read addr position length [block_size]\n");
+	printf("       sf bench [position] [length] [block_size]\n");
+	printf("       sf mode [single|dual]\n");
 }
 
 DEBUG_CMD("sf", "SPI flash", cmd_sf);
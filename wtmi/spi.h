@@ -13,6 +13,8 @@ extern const struct spi nordev;
 void spi_init(const struct spi *spi);
 void spi_nor_read_id(const struct spi *spi, u8 *id);
 void spi_nor_read(const struct spi *spi, void *dst, u32 pos, u32 len);
+int spi_nor_erase_4k(const struct spi *spi, u32 pos);
+int spi_nor_write(const struct spi *spi, const void *src, u32 pos, u32 len);
 void spi_write(const struct spi *spi, const void *buf, u32 len);
 
 #endif /* _SPI_H_ */
@@ -0,0 +1,182 @@
+#include "errno.h"
+#include "types.h"
+#include "string.h"
+#include "mbox.h"
+#include "stats.h"
+#include "debug.h"
+
+/* commands 0-15 have their own slot, Marvell OTP commands share the last one */
+#define STATS_CMD_SLOTS		17
+
+typedef u16 stats_hist_t[STATS_HIST_BUCKETS];
+
+static struct {
+	u32 count[STATS_CMD_SLOTS];
+	stats_hist_t wait[STATS_CMD_SLOTS];
+	stats_hist_t exec[STATS_CMD_SLOTS];
+	stats_hist_t send_spin;
+	u16 depth[CMD_QUEUE_SIZE];
+	u32 send_spins;
+	u32 queue_full;
+	u32 queue_max;
+} stats;
+
+void stats_init(void)
+{
+	dwt_enable();
+}
+
+static int cmd_slot(u16 cmd)
+{
+	return MIN(cmd, STATS_CMD_SLOTS - 1);
+}
+
+static inline void inc_sat(u16 *x)
+{
+	if (*x != 0xffff)
+		++*x;
+}
+
+static void hist_add(u16 *hist, u32 val)
+{
+	int b;
+
+	b = val ? 31 - __builtin_clz(val) - STATS_HIST_SHIFT : 0;
+	b = MIN(MAX(b, 0), STATS_HIST_BUCKETS - 1);
+
+	inc_sat(&hist[b]);
+}
+
+static void pack_u16(u32 *dst, const u16 *src, int n)
+{
+	int i;
+
+	for (i = 0; i < n; i += 2)
+		dst[i / 2] = src[i] | (src[i + 1] << 16);
+}
+
+void stats_cmd_done(u16 cmd, u32 wait, u32 exec)
+{
+	int slot = cmd_slot(cmd);
+
+	++stats.count[slot];
+	hist_add(stats.wait[slot], wait);
+	hist_add(stats.exec[slot], exec);
+}
+
+void stats_send_spin(u32 cycles)
+{
+	++stats.send_spins;
+	hist_add(stats.send_spin, cycles);
+}
+
+void stats_queue_full(void)
+{
+	++stats.queue_full;
+}
+
+void stats_queue_depth(int depth)
+{
+	inc_sat(&stats.depth[depth - 1]);
+	if (depth > stats.queue_max)
+		stats.queue_max = depth;
+}
+
+/*
+ * STATS_GLOBAL:
+ *   out_args[0] = number of commands rejected because the queue was full
+ *   out_args[1] = maximum queue depth
+ *   out_args[2] = number of times mbox_send had to wait for AP
+ *   out_args[3-10] = histogram of mbox_send wait times, 2 buckets per word
+ *   out_args[11-14] = how many times the queue had depth 1, 2, ..., 8 after
+ *                     a command was queued, 2 depths per word
+ *
+ * STATS_CMD_WAIT, STATS_CMD_EXEC:
+ *   out_args[0] = number of completed commands with ID cmd
+ *   out_args[1-8] = histogram of queue wait/execution times, 2 buckets per word
+ *
+ * STATS_RESET:
+ *   clears all statistics
+ */
+int stats_read(u32 what, u32 cmd, u32 *out_args)
+{
+	int slot = MIN(cmd, (u32)STATS_CMD_SLOTS - 1);
+
+	switch (what) {
+	case STATS_GLOBAL:
+		out_args[0] = stats.queue_full;
+		out_args[1] = stats.queue_max;
+		out_args[2] = stats.send_spins;
+		pack_u16(&out_args[3], stats.send_spin, STATS_HIST_BUCKETS);
+		pack_u16(&out_args[11], stats.depth, CMD_QUEUE_SIZE);
+		break;
+	case STATS_CMD_WAIT:
+		out_args[0] = stats.count[slot];
+		pack_u16(&out_args[1], stats.wait[slot], STATS_HIST_BUCKETS);
+		break;
+	case STATS_CMD_EXEC:
+		out_args[0] = stats.count[slot];
+		pack_u16(&out_args[1], stats.exec[slot], STATS_HIST_BUCKETS);
+		break;
+	case STATS_RESET:
+		bzero(&stats, sizeof(stats));
+		break;
+	default:
+		return -EINVAL;
+	}
+
+	return 0;
+}
+
+static void print_hist(const char *name, const u16 *hist)
+{
+	int i;
+
+	printf("  %s:", name);
+	for (i = 0; i < STATS_HIST_BUCKETS; ++i)
+		if (hist[i])
+			printf(" 2^%d:%u", i + STATS_HIST_SHIFT, hist[i]);
+	printf("\n");
+}
+
+DECL_DEBUG_CMD(cmd_stats)
+{
+	int i;
+
+	if (argc > 1) {
+		if (strcmp(argv[1], "reset"))
+			goto usage;
+
+		bzero(&stats, sizeof(stats));
+		return;
+	}
+
+	printf("Histograms are in CPU cycles, 2^n:count\n\n");
+	printf("Command queue: maximum depth %u, %u times full\n",
+	       stats.queue_max, stats.queue_full);
+	printf("  depth:");
+	for (i = 0; i < CMD_QUEUE_SIZE; ++i)
+		printf(" %d:%u", i + 1, stats.depth[i]);
+	printf("\n");
+
+	printf("mbox_send waited for AP %u times\n", stats.send_spins);
+	print_hist("wait", stats.send_spin);
+
+	for (i = 0; i < STATS_CMD_SLOTS; ++i) {
+		if (!stats.count[i])
+			continue;
+
+		if (i == STATS_CMD_SLOTS - 1)
+			printf("Marvell OTP commands: %u\n", stats.count[i]);
+		else
+			printf("Command %d: %u\n", i, stats.count[i]);
+		print_hist("queue wait", stats.wait[i]);
+		print_hist("execution", stats.exec[i]);
+	}
+
+	return;
+usage:
+	printf("usage: stats [reset]\n");
+}
+
+DEBUG_CMD("stats", "Show mailbox command statistics", cmd_stats);
@@ -0,0 +1,89 @@
+#ifndef _STATS_H_
+#define _STATS_H_
+
+#include "errno.h"
+#include "types.h"
+#include "io.h"
+
+#define DEMCR			0xe000edfc
+#define DEMCR_TRCENA		BIT(24)
+#define DWT_CTRL		0xe0001000
+#define DWT_CTRL_CYCCNTENA	BIT(0)
+#define DWT_CYCCNT		0xe0001004
+
+/*
+ * Histograms have STATS_HIST_BUCKETS logarithmic buckets, bucket i counting
+ * values in [2^(i + STATS_HIST_SHIFT), 2^(i + STATS_HIST_SHIFT + 1)) cycles.
+ * The first bucket also counts smaller values and the last one larger values.
+ */
+#define STATS_HIST_BUCKETS	16
+#define STATS_HIST_SHIFT	10
+
+enum stats_what {
+	STATS_GLOBAL = 0,
+	STATS_CMD_WAIT,
+	STATS_CMD_EXEC,
+	STATS_RESET,
+};
+
+static inline void dwt_enable(void)
+{
+	setbitsl(DEMCR, DEMCR_TRCENA, DEMCR_TRCENA);
+	writel(0, DWT_CYCCNT);
+	setbitsl(DWT_CTRL, DWT_CTRL_CYCCNTENA, DWT_CTRL_CYCCNTENA);
+}
+
+static inline u32 dwt_cycles(void)
+{
+	return readl(DWT_CYCCNT);
+}
+
+#ifndef WITHOUT_STATS
+
+extern void stats_init(void);
+extern void stats_cmd_done(u16 cmd, u32 wait, u32 exec);
+extern void stats_send_spin(u32 cycles);
+extern void stats_queue_full(void);
+extern void stats_queue_depth(int depth);
+extern int stats_read(u32 what, u32 cmd, u32 *out_args);
+
+static inline u32 stats_cycles(void)
+{
+	return dwt_cycles();
+}
+
+#else /* WITHOUT_STATS */
+
+static inline void stats_init(void)
+{
+}
+
+static inline void stats_cmd_done(u16 cmd, u32 wait, u32 exec)
+{
+}
+
+static inline void stats_send_spin(u32 cycles)
+{
+}
+
+static inline void stats_queue_full(void)
+{
+}
+
+static inline void stats_queue_depth(int depth)
+{
+}
+
+static inline int stats_read(u32 what, u32 cmd, u32 *out_args)
+{
+	return -EOPNOTSUPP;
+}
+
+static inline u32 stats_cycles(void)
+{
+	return 0;
+}
+
+#endif /* WITHOUT_STATS */
+
+#endif /* _STATS_H_ */
@@ -1,16 +1,50 @@
 #include "types.h"
 
-void bzero(void *dest, size_t n)
+/*
+ * memset, memcpy, memmove and memcmp process the part of the buffers where all
+ * pointers are word aligned by words (memcpy by LDM/STM bursts of 4 words), and
+ * the rest by bytes. No unaligned access is ever made, so these are safe also
+ * on device memory, such as the AP RAM window.
+ */
+
+/*
+ * Word accesses go through a may_alias type, since with LTO these are inlined
+ * into callers whose buffers have other types.
+ */
+typedef u32 __attribute__((may_alias)) u32_alias;
+
+static inline int co_aligned(const void *p1, const void *p2)
 {
-	u8 *d = dest;
-
-	while (n--)
-		*d++ = 0;
+	return !(((u32)p1 ^ (u32)p2) & 3);
 }
 
 void *memset(void *dest, int c, size_t n)
 {
 	u8 *d = dest;
+	u32 w;
+
+	if (n >= 8) {
+		while ((u32)d & 3) {
+			*d++ = c;
+			--n;
+		}
+
+		w = (u8)c * 0x01010101U;
+		while (n >= 16) {
+			((u32_alias *)d)[0] = w;
+			((u32_alias *)d)[1] = w;
+			((u32_alias *)d)[2] = w;
+			((u32_alias *)d)[3] = w;
+			d += 16;
+			n -= 16;
+		}
+
+		while (n >= 4) {
+			*(u32_alias *)d = w;
+			d += 4;
+			n -= 4;
+		}
+	}
 
 	while (n--)
 		*d++ = c;
@@ -18,12 +52,41 @@ void *memset(void *dest, int c, size_t n)
 	return dest;
 }
 
+void bzero(void *dest, size_t n)
+{
+	memset(dest, 0, n);
+}
+
+/* copies in ascending order, memmove() relies on it for forward moves */
 void *memcpy(void *dest, const void *src, size_t n)
 {
-	u8 *d = dest, *e = d + n;
+	u8 *d = dest;
 	const u8 *s = src;
 
-	while (d < e)
+	if (n >= 8 && co_aligned(d, s)) {
+		while ((u32)d & 3) {
+			*d++ = *s++;
+			--n;
+		}
+
+		while (n >= 16) {
+			asm volatile("ldmia %1!, {r3-r6}\n\t"
+				     "stmia %0!, {r3-r6}"
+				     : "+r" (d), "+r" (s)
+				     :
+				     : "r3", "r4", "r5", "r6", "memory");
+			n -= 16;
+		}
+
+		while (n >= 4) {
+			*(u32_alias *)d = *(const u32_alias *)s;
+			d += 4;
+			s += 4;
+			n -= 4;
+		}
+	}
+
+	while (n--)
 		*d++ = *s++;
 
 	return dest;
@@ -31,25 +94,59 @@ void *memcpy(void *dest, const void *src, size_t n)
 
 void *memmove(void *dest, const void *src, size_t n)
 {
-	if (dest == src) {
+	u8 *d;
+	const u8 *s;
+
+	if (dest == src)
 		return dest;
-	} else if (dest < src || src + n <= dest) {
+	else if (dest < src || src + n <= dest)
+		/* memcpy() copies upwards, which is safe when dest < src */
 		return memcpy(dest, src, n);
-	} else {
-		u8 *d = dest + n, *e = dest;
-		const u8 *s = src + n;
 
-		while (d > e)
-			*d-- = *s--;
-
-		return dest;
+	d = dest + n;
+	s = src + n;
+
+	if (n >= 8 && co_aligned(d, s)) {
+		while ((u32)d & 3) {
+			*--d = *--s;
+			--n;
+		}
+
+		while (n >= 4) {
+			d -= 4;
+			s -= 4;
+			*(u32_alias *)d = *(const u32_alias *)s;
+			n -= 4;
+		}
 	}
+
+	while (n--)
+		*--d = *--s;
+
+	return dest;
 }
 
 int memcmp(const void *_p1, const void *_p2, size_t n)
 {
-	const s8 *p1 = _p1, *p2 = _p2;
-	s8 d;
+	const u8 *p1 = _p1, *p2 = _p2;
+	int d;
+
+	if (n >= 8 && co_aligned(p1, p2)) {
+		while ((u32)p1 & 3) {
+			d = *p1++ - *p2++;
+			if (d)
+				return d;
+			--n;
+		}
+
+		/* skip equal words, the differing one is compared bytewise */
+		while (n >= 4 &&
+		       *(const u32_alias *)p1 == *(const u32_alias *)p2) {
+			p1 += 4;
+			p2 += 4;
+			n -= 4;
+		}
+	}
 
 	while (n--) {
 		d = *p1++ - *p2++;
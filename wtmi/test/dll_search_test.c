@@ -0,0 +1,177 @@
+/*
+ * Host test of the DLL passing window search in ddr/dll_search.c.
+ *
+ * The search is run against modelled byte lanes, whose passing phases are
+ * given by a bitmap, and compared with probing all phases as the firmware did
+ * before. For convex windows the results have to be the same. For others they
+ * may only differ if the coarse probes did not reveal the window as not
+ * convex, see the comment in ddr/dll_search.h.
+ *
+ * Two lanes are also searched together as short_dll_tune() does, to count the
+ * DLL resets needed compared to searching one lane after the other.
+ */
+#include <stdio.h>
+#include <stdint.h>
+#include "../ddr/dll_search.h"
+
+#define NUM_PHASES	(DLL_PHSEL_END - DLL_PHSEL_START + 1)
+
+static uint32_t seed = 0x2545f491;
+
+static uint32_t xorshift(void)
+{
+	seed ^= seed << 13;
+	seed ^= seed >> 17;
+	seed ^= seed << 5;
+	return seed;
+}
+
+static uint64_t window(int left, int right)
+{
+	if (left > right)
+		return 0;
+	return (~0ULL >> (63 - right + left)) << left;
+}
+
+static int passes(uint64_t lane, int phase)
+{
+	return (lane >> phase) & 1;
+}
+
+static int is_convex(uint64_t lane)
+{
+	return lane == 0 || !((lane >> __builtin_ctzll(lane)) &
+			      ((lane >> __builtin_ctzll(lane)) + 1));
+}
+
+/* the window as found by probing all phases */
+static void sweep(uint64_t lane, int *left, int *right)
+{
+	int i;
+
+	*left = DLL_PHSEL_END;
+	*right = DLL_PHSEL_START;
+	for (i = DLL_PHSEL_START; i <= DLL_PHSEL_END; i += DLL_PHSEL_STEP) {
+		if (!passes(lane, i))
+			continue;
+		if (i < *left)
+			*left = i;
+		if (i > *right)
+			*right = i;
+	}
+}
+
+static void search(uint64_t lane, struct dll_search *s, int *swept)
+{
+	*swept = 0;
+	dll_search_init(s);
+	while (s->state != DLL_SEARCH_DONE) {
+		dll_search_result(s, passes(lane, s->phase));
+		*swept |= s->state == DLL_SEARCH_SWEEP;
+	}
+}
+
+static long checked, failed;
+
+static void check(uint64_t lane, int *probes)
+{
+	struct dll_search s;
+	int left, right, swept;
+
+	sweep(lane, &left, &right);
+	search(lane, &s, &swept);
+	*probes = s.probes;
+	++checked;
+
+	if (s.left == left && s.right == right)
+		return;
+	if (!swept && !is_convex(lane))
+		return;
+
+	if (failed++ < 10)
+		printf("lane %016llx: found 0x%02x-0x%02x, all phases 0x%02x-0x%02x\n",
+		       (unsigned long long)lane, s.left, s.right, left, right);
+}
+
+/* search two lanes at once, return the number of DLL resets */
+static int search_both(uint64_t lane0, uint64_t lane1)
+{
+	struct dll_search s[2];
+	int resets = 0;
+
+	dll_search_init(&s[0]);
+	dll_search_init(&s[1]);
+	while (s[0].state != DLL_SEARCH_DONE || s[1].state != DLL_SEARCH_DONE) {
+		++resets;
+		if (s[0].state != DLL_SEARCH_DONE)
+			dll_search_result(&s[0], passes(lane0, s[0].phase));
+		if (s[1].state != DLL_SEARCH_DONE)
+			dll_search_result(&s[1], passes(lane1, s[1].phase));
+	}
+
+	return resets;
+}
+
+static uint64_t random_lane(void)
+{
+	int left = xorshift() % NUM_PHASES;
+	int right = left + xorshift() % (NUM_PHASES - left);
+	uint64_t lane = window(left, right);
+
+	switch (xorshift() % 4) {
+	case 0:
+		/* a failing phase within the window */
+		lane &= ~(1ULL << (left + xorshift() % (right - left + 1)));
+		break;
+	case 1:
+		/* a passing phase outside of it */
+		lane |= 1ULL << (xorshift() % NUM_PHASES);
+		break;
+	case 2:
+		lane = ((uint64_t)xorshift() << 32) | xorshift();
+		break;
+	}
+
+	return lane;
+}
+
+int main(void)
+{
+	long resets = 0, serial = 0, pairs = 0;
+	int left, right, probes, max_probes = 0;
+	uint64_t lane0, lane1;
+	long i;
+
+	/* every convex window, including the empty one */
+	check(0, &probes);
+	for (left = DLL_PHSEL_START; left <= DLL_PHSEL_END; ++left) {
+		for (right = left; right <= DLL_PHSEL_END; ++right) {
+			check(window(left, right), &probes);
+			if (probes > max_probes)
+				max_probes = probes;
+		}
+	}
+	printf("%ld convex windows, at most %d probes\n", checked, max_probes);
+
+	for (i = 0; i < 1000000; ++i)
+		check(random_lane(), &probes);
+
+	for (i = 0; i < 100000; ++i) {
+		int probes0, probes1;
+
+		lane0 = window(xorshift() % 24, 40 + xorshift() % 24);
+		lane1 = window(xorshift() % 24, 40 + xorshift() % 24);
+		check(lane0, &probes0);
+		check(lane1, &probes1);
+		resets += search_both(lane0, lane1);
+		serial += probes0 + probes1;
+		++pairs;
+	}
+
+	printf("%ld windows checked against probing all phases, %ld mismatches\n",
+	       checked, failed);
+	printf("DLL resets per pair of lanes: %.1f one after the other, %.1f together, %d probing all phases\n",
+	       (double)serial / pairs, (double)resets / pairs, 2 * NUM_PHASES);
+
+	return failed ? 1 : 0;
+}
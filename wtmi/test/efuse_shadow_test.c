@@ -0,0 +1,306 @@
+/*
+ * Host test of the eFuse row shadow in efuse.c.
+ *
+ * efuse.c is built against a model of the eFuse controller: reads return the
+ * row and, if asked to, check its ECC byte; programming sets a bit of a row
+ * unless it is locked. Random reads, writes, locking, row masking and ECC
+ * bytes going bad behind the firmware's back are done, and every read served
+ * by the shadow is compared with reading the row from the controller. The
+ * busy waiting and register accesses of the common mailbox reads are counted
+ * with and without the shadow.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* stand-ins for the firmware headers included by efuse.c */
+#define __TYPES_H
+#define _IO_H_
+#define _CLOCK_H_
+#define _MBOX_H_
+#define _STRING_H_
+#define _DEBUG_H_
+
+typedef unsigned long long	u64;
+typedef unsigned int		u32;
+typedef unsigned short		u16;
+typedef unsigned char		u8;
+typedef signed int		s32;
+typedef signed char		s8;
+
+#define BIT(n)			(1UL << (n))
+#define ARRAY_SIZE(x)		(sizeof((x)) / sizeof((x)[0]))
+#define maybe_unused		__attribute__((unused))
+
+u32 readl(u32 addr);
+void writel(u32 val, u32 addr);
+
+static inline void setbitsl(u32 addr, u32 val, u32 mask)
+{
+	writel((readl(addr) & ~mask) | (val & mask), addr);
+}
+
+void ndelay(u32 ns);
+void udelay(u32 us);
+
+#define DECL_DEBUG_CMD(f) \
+	static maybe_unused void f(int argc, char **argv)
+#define DEBUG_CMD(n,h,f)
+
+static inline int number(const char *str, u32 *pres)
+{
+	return -1;
+}
+
+static inline int decnumber(const char *str, u32 *pres)
+{
+	return -1;
+}
+
+#include "../efuse.c"
+
+static u64 fuse[44];
+static int fuse_lock[44];
+static u32 ctrl, rw, aux, d0, d1, mask0, mask1, sec_status;
+static u64 delay_ns, accesses;
+
+void ndelay(u32 ns)
+{
+	delay_ns += ns;
+}
+
+void udelay(u32 us)
+{
+	delay_ns += us * 1000ULL;
+}
+
+u32 readl(u32 addr)
+{
+	++accesses;
+	switch (addr) {
+	case EFUSE_CTRL:
+		return ctrl;
+	case EFUSE_AUX:
+		return aux;
+	case EFUSE_D0:
+		return d0;
+	case EFUSE_D1:
+		return d1;
+	case EFUSE_ROW_MASK0:
+		return mask0;
+	case EFUSE_ROW_MASK1:
+		return mask1;
+	case SEC_STATUS:
+		return sec_status;
+	default:
+		return 0;
+	}
+}
+
+/* the controller acts on the rising edge of bit 8 of EFUSE_CTRL */
+static void efuse_strobe(u32 val)
+{
+	int row = (rw >> 7) & 0x3f, col = rw & 0x7f;
+	u32 pos = val >> 24, status = 0;
+	u64 data;
+	u8 eccval;
+
+	if ((val & 0x7) == 0x3) {
+		/* read, optionally checking the ECC byte at pos */
+		data = row < 44 ? fuse[row] : 0;
+		if (row < 44 && pos && ecc[row].row >= 0) {
+			eccval = fuse[ecc[row].row] >> ((pos - 1) * 8);
+			if (eccval && eccval != (u8)secded_ecc(data))
+				status = 2;
+		}
+		d0 = data;
+		d1 = data >> 32;
+		aux = BIT(31) | BIT(29) | (status << 16) |
+		      (row < 44 && fuse_lock[row] ? 0x10 : 0);
+	} else if ((val & 0xf) == 0x8 && row < 44 && !fuse_lock[row]) {
+		fuse[row] |= 1ULL << col;
+	} else if ((val & 0xf) == 0xa && row < 44) {
+		fuse_lock[row] = 1;
+	}
+}
+
+void writel(u32 val, u32 addr)
+{
+	++accesses;
+	if (addr == EFUSE_RW) {
+		rw = val;
+	} else if (addr == EFUSE_CTRL) {
+		if ((val & 0x100) && !(ctrl & 0x100))
+			efuse_strobe(val);
+		ctrl = val;
+		aux |= BIT(29);
+	}
+}
+
+static u64 rand64(void)
+{
+	return ((u64)rand() << 33) ^ ((u64)rand() << 11) ^ rand();
+}
+
+/* reading the row from the controller, as without the shadow */
+static int uncached_read(int row, u64 *val, int *lock, int check_ecc)
+{
+	int res = _efuse_read_row(row, val, lock, check_ecc, 0);
+
+	if (is_row_masked(row))
+		return -EACCES;
+
+	return res;
+}
+
+static long checked, failed;
+
+static void check_row(int row, int check_ecc)
+{
+	u64 val = 0x1111, ref_val = 0x2222;
+	int lock = 7, ref_lock = 9, res, ref;
+
+	if (check_ecc)
+		res = efuse_read_row(row, &val, &lock);
+	else
+		res = efuse_read_row_no_ecc(row, &val, &lock);
+	ref = uncached_read(row, &ref_val, &ref_lock, check_ecc);
+	++checked;
+
+	if (res == ref && (ref == -EINVAL || (val == ref_val && lock == ref_lock)))
+		return;
+
+	if (failed++ < 10)
+		printf("row %d%s: %d %016llx lock %d, uncached %d %016llx lock %d\n",
+		       row, check_ecc ? " with ECC" : "", res,
+		       (unsigned long long)val, lock, ref,
+		       (unsigned long long)ref_val, ref_lock);
+}
+
+static void check_all_rows(void)
+{
+	int row;
+
+	for (row = 0; row < 44; ++row) {
+		check_row(row, 0);
+		check_row(row, 1);
+	}
+}
+
+static u64 bench_val;
+static int bench_lock;
+
+static void otp_read_uncached(void)
+{
+	uncached_read(5, &bench_val, &bench_lock, 0);
+}
+
+static void otp_read(void)
+{
+	efuse_read_row_no_ecc(5, &bench_val, &bench_lock);
+}
+
+static void otp_read_256b_uncached(void)
+{
+	int i;
+
+	for (i = 8; i < 12; ++i)
+		uncached_read(i, &bench_val, NULL, 0);
+}
+
+static void otp_read_256b(void)
+{
+	int i;
+
+	for (i = 8; i < 12; ++i)
+		efuse_read_row_no_ecc(i, &bench_val, NULL);
+}
+
+static void board_info_uncached(void)
+{
+	uncached_read(42, &bench_val, &bench_lock, 1);
+	uncached_read(43, &bench_val, &bench_lock, 1);
+}
+
+static void board_info(void)
+{
+	efuse_read_row(42, &bench_val, &bench_lock);
+	efuse_read_row(43, &bench_val, &bench_lock);
+}
+
+static void bench(const char *name, void (*fn)(void))
+{
+	u64 ns = delay_ns, acc = accesses;
+	int i;
+
+	for (i = 0; i < 1000; ++i)
+		fn();
+
+	printf("%-24s %6.0f ns busy waiting, %4.1f register accesses\n", name,
+	       (delay_ns - ns) / 1000.0, (accesses - acc) / 1000.0);
+}
+
+int main(void)
+{
+	u64 ns, acc;
+	long i;
+	int row;
+
+	srand(7);
+	for (row = 0; row < 44; ++row)
+		if (rand() % 2)
+			fuse[row] = rand64();
+
+	efuse_shadow_fill();
+	check_all_rows();
+
+	for (i = 0; i < 300000; ++i) {
+		switch (rand() % 20) {
+		case 0:
+			efuse_write_row_no_ecc(rand() % 44,
+					       1ULL << (rand() % 64),
+					       rand() % 8 == 0);
+			break;
+		case 1:
+			efuse_write_row_with_ecc_lock(rand() % 44, rand64());
+			check_all_rows();
+			break;
+		case 2:
+			sec_status = rand() % 2 ? BIT(1) : 0;
+			mask0 = rand();
+			mask1 = rand() & 0xfff;
+			break;
+		case 3:
+			/* a marginal fuse reading differently */
+			row = rand() % 44;
+			fuse[row] |= 1ULL << (rand() % 64);
+			efuse_shadow_invalidate(row);
+			check_all_rows();
+			break;
+		default:
+			check_row(rand() % 46 - 1, rand() % 2);
+			break;
+		}
+	}
+
+	printf("%ld reads checked against uncached reads, %ld mismatches\n",
+	       checked, failed);
+
+	sec_status = 0;
+	bench("OTP_READ, uncached", otp_read_uncached);
+	bench("OTP_READ", otp_read);
+	bench("OTP_READ_256B, uncached", otp_read_256b_uncached);
+	bench("OTP_READ_256B", otp_read_256b);
+	bench("BOARD_INFO, uncached", board_info_uncached);
+	bench("BOARD_INFO", board_info);
+
+	ns = delay_ns;
+	acc = accesses;
+	memset(shadow_flags, 0, sizeof(shadow_flags));
+	efuse_shadow_fill();
+	printf("filling the shadow: %llu ns busy waiting, %llu register accesses\n",
+	       (unsigned long long)(delay_ns - ns),
+	       (unsigned long long)(accesses - acc));
+
+	return failed ? 1 : 0;
+}
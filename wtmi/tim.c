@@ -384,37 +384,61 @@ static int load_tim(void)
 	return 0;
 }
 
-static int check_image_hash(imginfo_t *img, void *buf)
+static int image_hash_id(const imginfo_t *img)
 {
-	u32 digest[16];
-	int hashid;
+	if (img->encalg)
+		return -1;
 
 	if (img->hashalg == HASHALG_SHA256)
-		hashid = HASH_SHA256;
+		return HASH_SHA256;
 	else if (img->hashalg == HASHALG_SHA512)
-		hashid = HASH_SHA512;
+		return HASH_SHA512;
 	else
 		return -1;
+}
 
-	if (img->encalg)
+/*
+ * Read the image in chunks and hash each chunk while the next one is being
+ * read from the boot device, so that the digest is ready right after the last
+ * chunk arrives. The chunks are read directly into dest, which the hash engine
+ * then reads by DMA.
+ */
+#define LOAD_CHUNK	0x4000
+
+static int load_and_check_hash(const imginfo_t *img, int hashid, void *dest)
+{
+	u32 digest[16], pos, len;
+	hash_ctx_t ctx;
+
+	if (hw_hash_init(&ctx, hashid, img->size) < 0)
 		return -1;
 
-	memset(digest, 0, sizeof(digest));
-	if (memcmp(img->hash, digest, sizeof(digest))) {
-		/* hash is not zero, we have to check it */
-		if (hw_hash(hashid, buf, img->size, digest) < 0)
-			return -1;
+	for (pos = 0; pos < img->size; pos += len) {
+		len = MIN(img->size - pos, LOAD_CHUNK);
 
-		if (memcmp(img->hash, digest, sizeof(digest)))
-			return -1;
+		boot_device_read(dest + pos, img->flashentryaddr + pos, len);
+
+		hw_hash_update_wait();
+		if (pos + len < img->size)
+			hw_hash_update_start(&ctx, dest + pos, len);
+		else
+			hw_hash_update(&ctx, dest + pos, len);
 	}
 
+	memset(digest, 0, sizeof(digest));
+	hw_hash_final(&ctx, digest);
+
+	if (memcmp(img->hash, digest, sizeof(digest)))
+		return -1;
+
 	return 0;
 }
 
 int load_image(u32 id, void *dest, u32 *plen)
 {
+	u32 zero[16];
 	imginfo_t *img;
+	int hashid;
 
 	spi_init(&nordev);
 
@@ -425,13 +449,18 @@ int load_image(u32 id, void *dest, u32 *plen)
 	if (!img)
 		return -1;
 
-	if (img->hashalg != HASHALG_SHA256 && img->hashalg != HASHALG_SHA512)
+	hashid = image_hash_id(img);
+	if (hashid < 0)
 		return -1;
 
-	boot_device_read(dest, img->flashentryaddr, img->size);
-
-	if (check_image_hash(img, dest))
-		return -1;
+	memset(zero, 0, sizeof(zero));
+	if (memcmp(img->hash, zero, sizeof(zero))) {
+		/* hash is not zero, we have to check it */
+		if (load_and_check_hash(img, hashid, dest))
+			return -1;
+	} else {
+		boot_device_read(dest, img->flashentryaddr, img->size);
+	}
 
 	if (plen)
 		*plen = img->size;
@@ -1,6 +1,7 @@
 #include "types.h"
 #include "string.h"
 #include "crc32.h"
+#include "uboot-env.h"
 #include "spi.h"
 #include "debug.h"
 
@@ -9,24 +10,35 @@
 
 extern char uboot_env_buffer[0x2000];
 
+/*
+ * Check the CRC of the environment and leave its first window in
+ * uboot_env_buffer, so that parsing starts without reading it again. The rest
+ * of the region is only needed for the CRC and is streamed through a small
+ * bounce buffer. The environment usually fits into the first window, in which
+ * case every byte is read from SPI NOR only once.
+ */
 static int uboot_env_check_crc(void)
 {
+	static u32 tail[128];
 	char *buf = uboot_env_buffer;
 	u32 crc, stored_crc;
-	size_t pos;
+	size_t pos, len;
 
 	spi_nor_read(&nordev, &stored_crc, UBOOT_ENV_NOR_OFFSET, 4);
 
-	crc = 0xffffffff;
-
 	pos = sizeof(u32);
+	len = MIN(sizeof(uboot_env_buffer), UBOOT_ENV_NOR_SIZE - pos);
+	spi_nor_read(&nordev, buf, UBOOT_ENV_NOR_OFFSET + pos, len);
+
+	crc = crc32(0xffffffff, buf, len);
+	pos += len;
+
 	while (pos < UBOOT_ENV_NOR_SIZE) {
-		size_t len = MIN(sizeof(uboot_env_buffer),
-				 UBOOT_ENV_NOR_SIZE - pos);
+		len = MIN(sizeof(tail), UBOOT_ENV_NOR_SIZE - pos);
 
-		spi_nor_read(&nordev, buf, UBOOT_ENV_NOR_OFFSET + pos, len);
+		spi_nor_read(&nordev, tail, UBOOT_ENV_NOR_OFFSET + pos, len);
 
-		crc = crc32(crc, buf, len);
+		crc = crc32(crc, tail, len);
 		pos += len;
 	}
 
@@ -38,15 +50,16 @@ int uboot_env_for_each(int (*cb)(const char *var, const char *val, void *data),
 {
 	char *buf = uboot_env_buffer;
 	int ignore_first, ignored;
-	size_t pos;
+	size_t pos, loaded;
 
 	spi_init(&nordev);
 
 	if (!uboot_env_check_crc())
 		return -1;
 
-	/* skip crc */
+	/* skip crc, the first window is already loaded */
 	pos = sizeof(u32);
+	loaded = MIN(sizeof(uboot_env_buffer), UBOOT_ENV_NOR_SIZE - pos);
 
 	ignore_first = 0;
 	ignored = 0;
@@ -56,7 +69,12 @@ int uboot_env_for_each(int (*cb)(const char *var, const char *val, void *data),
 				 UBOOT_ENV_NOR_SIZE - pos);
 		char *p, *z, *e;
 
-		spi_nor_read(&nordev, buf, UBOOT_ENV_NOR_OFFSET + pos, len);
+		if (loaded) {
+			loaded = 0;
+		} else {
+			spi_nor_read(&nordev, buf, UBOOT_ENV_NOR_OFFSET + pos,
+				     len);
+		}
 
 		p = buf;
 		e = buf + len;